@@ -3,10 +3,16 @@ clear
 
 file = "p2p_queue_gs.txt";
 data = readtable("scratch/" + file);
+times = table2array(data(:,1));
 numbers = table2array(data(:,2));
 
-avg = mean(numbers)
-queueSum = sum(numbers)
+% The queue monitor writes a line whenever the occupancy changes, so each
+% value holds until the next line: weight it by that duration.
+durations = diff([times; times(end)]);
+avg = sum(numbers .* durations) / (times(end) - times(1))
+% The old script summed one 1 ms sample per line; the same sum from the
+% change events is the time integral in packet-milliseconds.
+queueSum = sum(numbers .* durations) / 0.001
 
 mu = 10000;
 lambda = 2500;
@@ -9,9 +9,10 @@ legends = ["P2P", "CSMA"];
 data1 = readtable("scratch/" + file_names(1) + ".txt");
 data2 = readtable("scratch/" + file_names(2) + ".txt");
 
-plot(table2array(data1(:,1)), table2array(data1(:,2)))
+% One line per occupancy change; the value holds until the next line.
+stairs(table2array(data1(:,1)), table2array(data1(:,2)))
 hold on
-plot(table2array(data2(:,1)), table2array(data2(:,2)))
+stairs(table2array(data2(:,1)), table2array(data2(:,2)))
 
 title("P2P vs CSMA/CD queue size")
 xlabel("Time (s)")
@@ -0,0 +1,179 @@
+#ifndef ALIAS_SAMPLER_H
+#define ALIAS_SAMPLER_H
+
+#include "ns3/core-module.h"
+#include "ns3/rng-stream.h"
+
+#include "bulk-rng.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Sampler for an arbitrary discrete distribution or histogram, using
+// Walker's alias method as built by Vose. Construction is O(k) for k
+// outcomes, every draw is O(1) and takes a single uniform:
+//
+//   i = floor(u * k), f = u * k - i
+//   outcome = f < prob[i] ? i : alias[i]
+//
+// Histogram bins are sampled uniformly inside the bin; the position is taken
+// from what is left of f once the coin has been tossed, so that still costs
+// one uniform per draw.
+//
+// Uniforms come from ns-3 RNG streams in blocks (see bulk-rng.h), so the
+// draws follow RngRun like any other ns-3 random variable.
+class Alias_sampler {
+public:
+  // Outcome values[i] with relative weight weights[i].
+  Alias_sampler(const std::vector<double> &values,
+                const std::vector<double> &weights)
+      : lo(values), width(values.size(), 0.0), continuous(false) {
+    build(weights);
+  }
+
+  // Uniform on [edges_lo[i], edges_hi[i]) with relative weight weights[i].
+  Alias_sampler(const std::vector<double> &edges_lo,
+                const std::vector<double> &edges_hi,
+                const std::vector<double> &weights)
+      : lo(edges_lo), width(edges_lo.size()), continuous(true) {
+    NS_ABORT_MSG_IF(edges_hi.size() != edges_lo.size(),
+                    "alias: histogram edges do not match");
+    for (std::size_t i = 0; i < lo.size(); i++)
+      width[i] = edges_hi[i] - edges_lo[i];
+    build(weights);
+  }
+
+  // Reads a PMF ("value weight" per line) or a histogram ("lo hi weight" per
+  // line). Blank lines and lines starting with '#' are skipped.
+  static Alias_sampler from_file(const std::string &path) {
+    std::ifstream in(path);
+    NS_ABORT_MSG_IF(!in.is_open(), "alias: cannot open " << path);
+
+    std::vector<double> first, second, weights;
+    std::string line;
+    int columns = 0;
+    while (std::getline(in, line)) {
+      if (line.empty() || line[0] == '#')
+        continue;
+
+      std::istringstream fields(line);
+      std::vector<double> row;
+      double v;
+      while (fields >> v)
+        row.push_back(v);
+      if (row.empty())
+        continue;
+
+      NS_ABORT_MSG_IF(row.size() != 2 && row.size() != 3,
+                      "alias: " << path << ": expected 2 or 3 columns in '"
+                                << line << "'");
+      NS_ABORT_MSG_IF(columns != 0 && (int)row.size() != columns,
+                      "alias: " << path << ": mixed column counts");
+      columns = row.size();
+
+      first.push_back(row[0]);
+      if (columns == 3)
+        second.push_back(row[1]);
+      weights.push_back(row.back());
+    }
+
+    if (columns == 3)
+      return Alias_sampler(first, second, weights);
+    return Alias_sampler(first, weights);
+  }
+
+  std::size_t size() const { return table.size(); }
+
+  // Maps each uniform in u[0..n) to a draw, in place.
+  void transform_inplace(double *u, std::size_t n) const {
+    const std::size_t k = table.size();
+    const double scale = (double)k;
+
+    if (!continuous) {
+      for (std::size_t j = 0; j < n; j++) {
+        double x = u[j] * scale;
+        std::size_t i = std::min((std::size_t)x, k - 1);
+        const Cell &cell = table[i];
+        u[j] = lo[x - i < cell.prob ? i : cell.alias];
+      }
+      return;
+    }
+
+    for (std::size_t j = 0; j < n; j++) {
+      double x = u[j] * scale;
+      std::size_t i = std::min((std::size_t)x, k - 1);
+      const Cell &cell = table[i];
+      double f = x - i;
+      bool keep = f < cell.prob;
+      std::size_t outcome = keep ? i : cell.alias;
+      double within =
+          keep ? f / cell.prob : (f - cell.prob) / (1 - cell.prob);
+      u[j] = lo[outcome] + width[outcome] * within;
+    }
+  }
+
+  void sample(ns3::RngStream *rng, double *out, std::size_t n) const {
+    bulk_u01(rng, out, n);
+    transform_inplace(out, n);
+  }
+
+  void sample(ns3::Ptr<ns3::RandomVariableStream> x, double *out,
+              std::size_t n) const {
+    bulk_u01(x, out, n);
+    transform_inplace(out, n);
+  }
+
+private:
+  struct Cell {
+    double prob;
+    uint32_t alias;
+  };
+
+  void build(const std::vector<double> &weights) {
+    const std::size_t k = weights.size();
+    NS_ABORT_MSG_IF(k == 0 || k != lo.size(), "alias: empty or ragged table");
+
+    double total = 0;
+    for (double w : weights) {
+      NS_ABORT_MSG_IF(!(w >= 0), "alias: negative weight " << w);
+      total += w;
+    }
+    NS_ABORT_MSG_IF(!(total > 0), "alias: weights sum to zero");
+
+    std::vector<double> scaled(k);
+    std::vector<uint32_t> small, large;
+    for (std::size_t i = 0; i < k; i++) {
+      scaled[i] = weights[i] * k / total;
+      (scaled[i] < 1 ? small : large).push_back(i);
+    }
+
+    table.resize(k);
+    while (!small.empty() && !large.empty()) {
+      uint32_t s = small.back(), l = large.back();
+      small.pop_back();
+      large.pop_back();
+
+      table[s].prob = scaled[s];
+      table[s].alias = l;
+      scaled[l] = (scaled[l] + scaled[s]) - 1;
+      (scaled[l] < 1 ? small : large).push_back(l);
+    }
+
+    // Whatever is left is 1 up to rounding.
+    for (uint32_t i : large)
+      table[i].prob = 1, table[i].alias = i;
+    for (uint32_t i : small)
+      table[i].prob = 1, table[i].alias = i;
+  }
+
+  std::vector<Cell> table;
+  std::vector<double> lo, width;
+  bool continuous;
+};
+
+#endif /* ALIAS_SAMPLER_H */
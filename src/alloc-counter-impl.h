@@ -0,0 +1,66 @@
+#ifndef ALLOC_COUNTER_IMPL_H
+#define ALLOC_COUNTER_IMPL_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "alloc-counter.h"
+
+// Counting replacements for the global operator new/delete behind
+// alloc_snapshot() (see alloc-counter.h). They apply to the whole process,
+// ns-3 libraries included.
+//
+// Include this from exactly one translation unit of a program, the one with
+// main().
+
+static std::atomic<uint64_t> alloc_calls(0);
+static std::atomic<uint64_t> alloc_bytes(0);
+
+Alloc_snapshot alloc_snapshot() {
+  Alloc_snapshot s;
+  s.calls = alloc_calls.load(std::memory_order_relaxed);
+  s.bytes = alloc_bytes.load(std::memory_order_relaxed);
+  return s;
+}
+
+static void *alloc_counted(std::size_t size) {
+  alloc_calls.fetch_add(1, std::memory_order_relaxed);
+  alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+  return std::malloc(size ? size : 1);
+}
+
+void *operator new(std::size_t size) {
+  void *p = alloc_counted(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new[](std::size_t size) {
+  void *p = alloc_counted(size);
+  if (!p)
+    throw std::bad_alloc();
+  return p;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept {
+  return alloc_counted(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept {
+  return alloc_counted(size);
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete[](void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept { std::free(p); }
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  std::free(p);
+}
+
+#endif /* ALLOC_COUNTER_IMPL_H */
@@ -0,0 +1,20 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <cstdint>
+
+// How many allocations (and bytes) the process has made so far, so a
+// program can report what a piece of code costs by taking two snapshots.
+//
+// The counting itself is done by replacements for the global operator
+// new/delete in alloc-counter-impl.h, which one translation unit of the
+// program has to include; this header only declares the snapshot and can be
+// included anywhere.
+
+struct Alloc_snapshot {
+  uint64_t calls, bytes;
+};
+
+Alloc_snapshot alloc_snapshot();
+
+#endif /* ALLOC_COUNTER_H */
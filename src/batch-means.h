@@ -0,0 +1,139 @@
+#ifndef BATCH_MEANS_H
+#define BATCH_MEANS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+// Two-sided 95% quantile of Student's t with df degrees of freedom.
+inline double StudentT975(uint64_t df) {
+  static const double table[] = {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+      2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+      2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (df == 0)
+    return NAN;
+  if (df <= 30)
+    return table[df - 1];
+
+  // Cornish-Fisher expansion around the normal quantile.
+  double z = 1.959963984540054, n = (double)df;
+  double z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+  return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n) +
+         (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n);
+}
+
+// Steady-state mean of a correlated series, e.g. a queue's occupancy over
+// successive intervals, with a 95% confidence interval.
+//
+// The start-up transient is cut with MSER-5: the observations are averaged
+// in fives, and the truncation point is the one that minimises the squared
+// standard error of the mean of what is left, sum (x_i - mean)^2 / n^2,
+// searched over the first half only. What is left is split into Batches
+// contiguous batches whose means are taken as independent. Each observation
+// can carry a weight, such as the number of packets behind an interval's
+// mean delay; the mean and the batch means are then weighted, the interval
+// is taken over the batch means as they are.
+class BatchMeans {
+public:
+  BatchMeans(uint32_t batches = 20) : m_batches(batches) {}
+
+  void Add(double value, double weight = 1) {
+    m_values.push_back(value);
+    m_weights.push_back(weight);
+  }
+
+  uint64_t GetCount() const { return m_values.size(); }
+
+  // Observations dropped as warm-up.
+  uint64_t GetWarmup() const {
+    const uint64_t group = 5;
+    uint64_t groups = m_values.size() / group;
+    if (groups < 2)
+      return 0;
+    std::vector<double> sums(groups), weights(groups);
+    for (uint64_t g = 0; g < groups; g++) {
+      for (uint64_t i = g * group; i < (g + 1) * group; i++) {
+        sums[g] += m_values[i] * m_weights[i];
+        weights[g] += m_weights[i];
+      }
+    }
+
+    // Suffix sums give each truncation's mean and spread in one pass from
+    // the end: sum w (x - mean)^2 = sum w x^2 - (sum w x)^2 / sum w.
+    double w = 0, wx = 0, wx2 = 0, best = INFINITY;
+    uint64_t cut = 0;
+    for (uint64_t d = groups; d-- > 0;) {
+      double x = weights[d] > 0 ? sums[d] / weights[d] : 0;
+      w += weights[d];
+      wx += weights[d] * x;
+      wx2 += weights[d] * x * x;
+      if (d > groups / 2 || w <= 0)
+        continue;
+      double mser = std::max(wx2 - wx * wx / w, 0.0) / (w * w);
+      if (mser <= best) {
+        best = mser;
+        cut = d;
+      }
+    }
+    return cut * group;
+  }
+
+  // Whether the warm-up looks over: MSER-5 cut before the last allowed
+  // point and enough observations are left for two per batch.
+  bool IsSteady() const {
+    uint64_t warmup = GetWarmup();
+    uint64_t groups = m_values.size() / 5;
+    return warmup / 5 < groups / 2 &&
+           m_values.size() - warmup >= 2 * (uint64_t)m_batches;
+  }
+
+  double GetMean() const {
+    double w = 0, wx = 0;
+    for (uint64_t i = GetWarmup(); i < m_values.size(); i++) {
+      w += m_weights[i];
+      wx += m_weights[i] * m_values[i];
+    }
+    return w > 0 ? wx / w : 0;
+  }
+
+  // Half-width of the 95% interval from the batch means, NaN with fewer
+  // observations than batches.
+  double GetHalfWidth() const {
+    uint64_t warmup = GetWarmup();
+    uint64_t n = m_values.size() - warmup;
+    if (n < m_batches || m_batches < 2)
+      return NAN;
+    uint64_t size = n / m_batches;
+    uint64_t first = m_values.size() - size * m_batches;
+
+    std::vector<double> means(m_batches);
+    double total = 0;
+    for (uint32_t b = 0; b < m_batches; b++) {
+      double w = 0, wx = 0;
+      for (uint64_t i = first + b * size; i < first + (b + 1) * size; i++) {
+        w += m_weights[i];
+        wx += m_weights[i] * m_values[i];
+      }
+      means[b] = w > 0 ? wx / w : 0;
+      total += means[b];
+    }
+    double mean = total / m_batches, ss = 0;
+    for (double m : means)
+      ss += (m - mean) * (m - mean);
+    double variance = ss / (m_batches - 1);
+    return StudentT975(m_batches - 1) * std::sqrt(variance / m_batches);
+  }
+
+private:
+  uint32_t m_batches;
+  std::vector<double> m_values;
+  std::vector<double> m_weights;
+};
+
+} // namespace ns3
+
+#endif /* BATCH_MEANS_H */
@@ -0,0 +1,106 @@
+#ifndef BULK_RNG_H
+#define BULK_RNG_H
+
+#include <cmath>
+#include <cstddef>
+
+#include "ns3/core-module.h"
+#include "ns3/rng-stream.h"
+
+// Bulk sampling for ns-3 random variables. Each call fills a whole span from
+// the variable's own MRG32k3a stream: the raw uniforms are pulled in one
+// tight loop, then transformed in a second one, instead of going through the
+// virtual GetValue() and the attribute lookups once per sample.
+//
+// The output is the sequence GetValue() would have returned for the same
+// RngRun and stream, value for value, and the stream is left at the same
+// position, so bulk and per-call draws can be mixed freely.
+
+// RandomVariableStream::Peek() is protected. A pointer to member formed
+// through a derived class is the standard way to reach it from outside.
+struct Rng_stream_access : public ns3::RandomVariableStream {
+  static ns3::RngStream *get(ns3::Ptr<ns3::RandomVariableStream> x) {
+    return (ns3::PeekPointer(x)->*(&Rng_stream_access::Peek))();
+  }
+};
+
+// The transforms work on a bare RngStream so they can also drive streams
+// that are not owned by a random variable, e.g. one substream per block.
+
+// Raw U(0, 1) draws, exactly the values RandU01() returns.
+inline void bulk_u01(ns3::RngStream *rng, double *out, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++)
+    out[i] = rng->RandU01();
+}
+
+// UniformRandomVariable::GetValue(min, max).
+inline void bulk_uniform(ns3::RngStream *rng, double min, double max,
+                         bool antithetic, double *out, std::size_t n) {
+  bulk_u01(rng, out, n);
+  for (std::size_t i = 0; i < n; i++)
+    out[i] = min + out[i] * (max - min);
+
+  if (antithetic) {
+    for (std::size_t i = 0; i < n; i++)
+      out[i] = min + (max - out[i]);
+  }
+}
+
+// ExponentialRandomVariable::GetValue(mean, bound).
+//
+// GetValue() redraws whenever a value exceeds Bound. Here every pass draws
+// one uniform per missing sample, keeps the accepted values in order and
+// repeats for the shortfall, which consumes the stream in the same order and
+// yields the same values.
+inline void bulk_exponential(ns3::RngStream *rng, double mean, double bound,
+                             bool antithetic, double *out, std::size_t n) {
+  std::size_t filled = 0;
+  while (filled < n) {
+    double *u = out + filled;
+    std::size_t k = n - filled;
+
+    bulk_u01(rng, u, k);
+    if (antithetic) {
+      for (std::size_t i = 0; i < k; i++)
+        u[i] = 1 - u[i];
+    }
+    for (std::size_t i = 0; i < k; i++)
+      u[i] = -mean * std::log(u[i]);
+
+    if (bound == 0)
+      return;
+
+    for (std::size_t i = 0; i < k; i++) {
+      if (u[i] <= bound)
+        out[filled++] = u[i];
+    }
+  }
+}
+
+inline void bulk_u01(ns3::Ptr<ns3::RandomVariableStream> x, double *out,
+                     std::size_t n) {
+  bulk_u01(Rng_stream_access::get(x), out, n);
+}
+
+// UniformRandomVariable::GetValue() with its Min/Max attributes.
+inline void bulk_uniform(ns3::Ptr<ns3::UniformRandomVariable> x, double *out,
+                         std::size_t n) {
+  bulk_uniform(Rng_stream_access::get(x), x->GetMin(), x->GetMax(),
+               x->IsAntithetic(), out, n);
+}
+
+// ExponentialRandomVariable::GetValue() with its Mean/Bound attributes.
+inline void bulk_exponential(ns3::Ptr<ns3::ExponentialRandomVariable> x,
+                             double *out, std::size_t n) {
+  bulk_exponential(Rng_stream_access::get(x), x->GetMean(), x->GetBound(),
+                   x->IsAntithetic(), out, n);
+}
+
+// Any other variable, one virtual call per value.
+inline void bulk_values(ns3::Ptr<ns3::RandomVariableStream> x, double *out,
+                        std::size_t n) {
+  for (std::size_t i = 0; i < n; i++)
+    out[i] = x->GetValue();
+}
+
+#endif /* BULK_RNG_H */
@@ -0,0 +1,103 @@
+#ifndef COUNTING_SCHEDULER_H
+#define COUNTING_SCHEDULER_H
+
+#include <cstdint>
+#include <string>
+
+#include <sys/resource.h>
+
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// Scheduler that keeps its events in another one, named by the Inner
+// attribute, and records the largest number of events it has held. Used
+// by the part3 --benchmark mode to compare the event set implementations on
+// the same run.
+//
+// The simulator creates its scheduler from a factory and does not hand it
+// out, so the peak is kept across instances and read with GetPeakSize().
+class CountingScheduler : public Scheduler {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::CountingScheduler")
+            .SetParent<Scheduler>()
+            .AddConstructor<CountingScheduler>()
+            .AddAttribute("Inner", "Scheduler that holds the events",
+                          StringValue("ns3::MapScheduler"),
+                          MakeStringAccessor(&CountingScheduler::SetInner),
+                          MakeStringChecker());
+    return tid;
+  }
+
+  CountingScheduler() : m_size(0) {}
+
+  virtual void Insert(const Event &ev) {
+    m_inner->Insert(ev);
+    if (++m_size > PeakSize())
+      PeakSize() = m_size;
+  }
+
+  virtual bool IsEmpty() const { return m_inner->IsEmpty(); }
+  virtual Event PeekNext() const { return m_inner->PeekNext(); }
+
+  virtual Event RemoveNext() {
+    m_size--;
+    return m_inner->RemoveNext();
+  }
+
+  virtual void Remove(const Event &ev) {
+    m_size--;
+    m_inner->Remove(ev);
+  }
+
+  static uint64_t GetPeakSize() { return PeakSize(); }
+
+private:
+  void SetInner(std::string name) {
+    NS_ABORT_MSG_IF(m_inner && !m_inner->IsEmpty(),
+                    "CountingScheduler: Inner set while holding events");
+    ObjectFactory factory;
+    factory.SetTypeId(name);
+    m_inner = factory.Create<Scheduler>();
+  }
+
+  static uint64_t &PeakSize() {
+    static uint64_t peak = 0;
+    return peak;
+  }
+
+  Ptr<Scheduler> m_inner;
+  uint64_t m_size;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(CountingScheduler);
+
+// "map", "heap", "list", "calendar" and "priorityqueue" for the schedulers
+// ns-3 comes with; anything else is taken as a TypeId name.
+inline std::string SchedulerTypeName(std::string name) {
+  if (name == "map")
+    return "ns3::MapScheduler";
+  if (name == "heap")
+    return "ns3::HeapScheduler";
+  if (name == "list")
+    return "ns3::ListScheduler";
+  if (name == "calendar")
+    return "ns3::CalendarScheduler";
+  if (name == "priorityqueue")
+    return "ns3::PriorityQueueScheduler";
+  return name;
+}
+
+// Peak resident set size of this process in kilobytes.
+inline uint64_t PeakRssKilobytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return usage.ru_maxrss;
+}
+
+} // namespace ns3
+
+#endif /* COUNTING_SCHEDULER_H */
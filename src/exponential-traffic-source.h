@@ -0,0 +1,241 @@
+#ifndef EXPONENTIAL_TRAFFIC_SOURCE_H
+#define EXPONENTIAL_TRAFFIC_SOURCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "bulk-rng.h"
+
+namespace ns3 {
+
+// Poisson packet source: exponential gaps with mean MeanInterval seconds and
+// exponential sizes with mean MeanSize bytes, sent over UDP to Remote.
+//
+// Gaps and sizes are drawn BlockSize values at a time (see bulk-rng.h), and
+// the application keeps a single pending event, so a packet costs an array
+// read and one Schedule() with no arguments to copy.
+//
+// Sizes below MinSize are raised to MinSize by default, as GenerateTraffic()
+// did. With TruncateSize the size is MinSize plus the exponential draw
+// instead, i.e. the exponential left-truncated at MinSize, and MaxSize (if
+// not 0) bounds the draw by rejection in both cases.
+//
+// With a non-zero Tick, sends are rounded up to the next multiple of Tick
+// and all packets due in the same tick go out from one event.
+//
+// With Antithetic, gaps and sizes come from 1 - U instead of the stream's
+// U, so a run and its antithetic twin make a negatively correlated pair.
+//
+// SetRateScale() speeds the source up for importance sampling: gaps drawn
+// from then on are divided by the scale, which is the exponential twist of
+// the gap distribution, and the source keeps the log of the likelihood
+// ratio of every gap drawn, sum -ln(scale) + (scale - 1) * gap / mean, the
+// weight that makes the twisted run estimate the original one (see
+// overflow-estimator.h). The gaps come from the same draws either way.
+class ExponentialTrafficSource : public Application {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::ExponentialTrafficSource")
+            .SetParent<Application>()
+            .AddConstructor<ExponentialTrafficSource>()
+            .AddAttribute("Remote", "Destination of the packets",
+                          AddressValue(),
+                          MakeAddressAccessor(
+                              &ExponentialTrafficSource::m_remote),
+                          MakeAddressChecker())
+            .AddAttribute("MeanInterval",
+                          "Mean time between packets in seconds",
+                          DoubleValue(0.002),
+                          MakeDoubleAccessor(
+                              &ExponentialTrafficSource::m_meanInterval),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MeanSize", "Mean packet size in bytes",
+                          DoubleValue(200),
+                          MakeDoubleAccessor(
+                              &ExponentialTrafficSource::m_meanSize),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MinSize",
+                          "Smallest packet size; UdpServer needs 12 bytes "
+                          "for its sequence header",
+                          UintegerValue(12),
+                          MakeUintegerAccessor(
+                              &ExponentialTrafficSource::m_minSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("MaxSize", "Largest packet size, 0 for no bound",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(
+                              &ExponentialTrafficSource::m_maxSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("TruncateSize",
+                          "Shift sizes by MinSize instead of raising small "
+                          "ones to it",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(
+                              &ExponentialTrafficSource::m_truncateSize),
+                          MakeBooleanChecker())
+            .AddAttribute("Tick",
+                          "Send granularity, 0 to send every packet when due",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&ExponentialTrafficSource::m_tick),
+                          MakeTimeChecker())
+            .AddAttribute("Antithetic",
+                          "Draw gaps and sizes from 1 - U",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(
+                              &ExponentialTrafficSource::m_antithetic),
+                          MakeBooleanChecker())
+            .AddAttribute("BlockSize",
+                          "Number of gaps and sizes drawn at once",
+                          UintegerValue(256),
+                          MakeUintegerAccessor(
+                              &ExponentialTrafficSource::m_blockSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddTraceSource("Tx", "A packet is sent",
+                            MakeTraceSourceAccessor(
+                                &ExponentialTrafficSource::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+  }
+
+  ExponentialTrafficSource()
+      : m_meanInterval(0.002), m_meanSize(200), m_minSize(12), m_maxSize(0),
+        m_truncateSize(false), m_antithetic(false), m_blockSize(256),
+        m_nextGap(0), m_nextSize(0), m_rateScale(1),
+        m_logLikelihoodRatio(0), m_sent(0) {
+    m_interval = CreateObject<ExponentialRandomVariable>();
+    m_size = CreateObject<ExponentialRandomVariable>();
+  }
+
+  int64_t AssignStreams(int64_t stream) {
+    m_interval->SetStream(stream);
+    m_size->SetStream(stream + 1);
+    // Drop what was drawn from the previous streams.
+    m_gaps.clear();
+    m_sizes.clear();
+    m_nextGap = m_nextSize = 0;
+    return 2;
+  }
+
+  uint64_t GetSent() const { return m_sent; }
+
+  void SetRateScale(double scale) {
+    NS_ABORT_MSG_IF(!(scale > 0), "ExponentialTrafficSource: scale <= 0");
+    m_rateScale = scale;
+  }
+  double GetRateScale() const { return m_rateScale; }
+  // Of the original over the actual distribution of the gaps so far.
+  double GetLogLikelihoodRatio() const { return m_logLikelihoodRatio; }
+
+protected:
+  virtual void DoDispose() {
+    m_socket = 0;
+    m_interval = 0;
+    m_size = 0;
+    Application::DoDispose();
+  }
+
+private:
+  virtual void StartApplication() {
+    if (!m_socket) {
+      m_socket = Socket::CreateSocket(GetNode(), UdpSocketFactory::GetTypeId());
+      m_socket->Bind();
+      m_socket->Connect(m_remote);
+    }
+
+    m_interval->SetAttribute("Mean", DoubleValue(m_meanInterval));
+    m_size->SetAttribute("Mean", DoubleValue(m_meanSize));
+    uint32_t bound = m_maxSize;
+    if (m_truncateSize && bound > 0)
+      bound = bound > m_minSize ? bound - m_minSize : 1;
+    m_size->SetAttribute("Bound", DoubleValue(bound));
+    m_interval->SetAttribute("Antithetic", BooleanValue(m_antithetic));
+    m_size->SetAttribute("Antithetic", BooleanValue(m_antithetic));
+
+    // The first packet goes out right away, like GenerateTraffic() did.
+    m_due = Simulator::Now();
+    Emit();
+  }
+
+  virtual void StopApplication() { m_event.Cancel(); }
+
+  void Emit() {
+    Time now = Simulator::Now();
+    do {
+      Ptr<Packet> packet = Create<Packet>(NextSize());
+      m_txTrace(packet);
+      m_socket->Send(packet);
+      m_sent++;
+      m_due += Seconds(NextGap());
+    } while (m_due <= now);
+
+    Time at = m_due;
+    if (m_tick.IsStrictlyPositive()) {
+      int64_t tick = m_tick.GetTimeStep();
+      at = TimeStep((m_due.GetTimeStep() + tick - 1) / tick * tick);
+    }
+    m_event = Simulator::Schedule(at - now, &ExponentialTrafficSource::Emit,
+                                  this);
+  }
+
+  double NextGap() {
+    if (m_nextGap == m_gaps.size()) {
+      m_gaps.resize(m_blockSize);
+      bulk_exponential(m_interval, m_gaps.data(), m_gaps.size());
+      m_nextGap = 0;
+    }
+    double gap = m_gaps[m_nextGap++];
+    if (m_rateScale != 1) {
+      gap /= m_rateScale;
+      m_logLikelihoodRatio +=
+          (m_rateScale - 1) * gap / m_meanInterval - std::log(m_rateScale);
+    }
+    return gap;
+  }
+
+  uint32_t NextSize() {
+    if (m_nextSize == m_sizes.size()) {
+      m_sizes.resize(m_blockSize);
+      bulk_exponential(m_size, m_sizes.data(), m_sizes.size());
+      m_nextSize = 0;
+    }
+    uint32_t size = (uint32_t)m_sizes[m_nextSize++];
+    return m_truncateSize ? m_minSize + size : std::max(size, m_minSize);
+  }
+
+  Address m_remote;
+  double m_meanInterval;
+  double m_meanSize;
+  uint32_t m_minSize;
+  uint32_t m_maxSize;
+  bool m_truncateSize;
+  Time m_tick;
+  bool m_antithetic;
+  uint32_t m_blockSize;
+
+  Ptr<Socket> m_socket;
+  Ptr<ExponentialRandomVariable> m_interval;
+  Ptr<ExponentialRandomVariable> m_size;
+  std::vector<double> m_gaps, m_sizes;
+  std::size_t m_nextGap, m_nextSize;
+  double m_rateScale;
+  double m_logLikelihoodRatio;
+
+  Time m_due;
+  EventId m_event;
+  uint64_t m_sent;
+  TracedCallback<Ptr<const Packet>> m_txTrace;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ExponentialTrafficSource);
+
+} // namespace ns3
+
+#endif /* EXPONENTIAL_TRAFFIC_SOURCE_H */
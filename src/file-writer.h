@@ -0,0 +1,184 @@
+#ifndef FILE_WRITER_H
+#define FILE_WRITER_H
+
+#include "ns3/core-module.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Streaming writer for the part1 series. Values are pushed in chunks and
+// flushed through a fixed-size buffer as they arrive, so memory stays bounded
+// by the buffer size no matter how long a series is.
+//
+// NONE generates nothing on disk, for timing the generators alone.
+//
+// CSV keeps the old layout: one series per line, values separated by ", ".
+//
+// BINARY is columnar, little-endian:
+//   file header   "P1SERIES" | u32 version | u32 series count
+//   series header u32 name length | name | u32 dtype (1 = f64) | u64 count
+//   series data   count * f64
+// The counts are patched in when a series (or the file) is closed.
+//
+// A file that cannot be opened or written aborts the program rather than
+// leaving a missing or truncated series behind.
+class File_writer {
+public:
+  enum Format { NONE, CSV, BINARY };
+
+private:
+  static const uint32_t version = 1;
+  static const uint32_t dtype_f64 = 1;
+  static const size_t buffer_size = 1 << 20;
+
+  std::string filename;
+  std::string path;
+  Format format = CSV;
+  std::FILE *file = nullptr;
+  std::vector<char> buffer;
+  size_t used = 0;
+  uint32_t series = 0;
+  uint64_t count = 0;
+  long count_offset = -1;
+
+  void write_out(const void *bytes, size_t size) {
+    NS_ABORT_MSG_IF(std::fwrite(bytes, 1, size, this->file) != size,
+                    "File_writer: cannot write " << this->path);
+  }
+
+  void flush() {
+    if (this->used > 0)
+      write_out(this->buffer.data(), this->used);
+    this->used = 0;
+  }
+
+  void put(const void *bytes, size_t size) {
+    if (this->used + size > this->buffer.size())
+      flush();
+    if (size > this->buffer.size()) {
+      write_out(bytes, size);
+      return;
+    }
+    std::memcpy(this->buffer.data() + this->used, bytes, size);
+    this->used += size;
+  }
+
+  // Overwrites a u32/u64 that has already left the buffer.
+  void patch(long offset, const void *bytes, size_t size) {
+    flush();
+    long end = std::ftell(this->file);
+    NS_ABORT_MSG_IF(offset < 0 || end < 0 ||
+                        std::fseek(this->file, offset, SEEK_SET) != 0,
+                    "File_writer: cannot seek in " << this->path);
+    write_out(bytes, size);
+    NS_ABORT_MSG_IF(std::fseek(this->file, end, SEEK_SET) != 0,
+                    "File_writer: cannot seek in " << this->path);
+  }
+
+  bool open() {
+    if (this->file)
+      return true;
+    if (this->format == NONE)
+      return false;
+
+    this->path = this->filename + (this->format == BINARY ? ".bin" : ".csv");
+    this->file = std::fopen(this->path.c_str(), "wb");
+    NS_ABORT_MSG_IF(!this->file, "File_writer: cannot open " << this->path);
+
+    this->buffer.resize(buffer_size);
+    if (this->format == BINARY) {
+      uint32_t header[2] = {version, 0};
+      put("P1SERIES", 8);
+      put(header, sizeof(header));
+    }
+    return true;
+  }
+
+public:
+  File_writer() = default;
+  ~File_writer() { close(); }
+
+  // The writer owns its FILE; a copy would close it a second time.
+  File_writer(const File_writer &) = delete;
+  File_writer &operator=(const File_writer &) = delete;
+
+  void set_filename(std::string filename) { this->filename = filename; }
+
+  void set_format(Format format) { this->format = format; }
+
+  void begin_series(const std::string &name) {
+    if (!open())
+      return;
+
+    this->count = 0;
+    if (this->format == BINARY) {
+      uint32_t length = name.size(), dtype = dtype_f64;
+      uint64_t zero = 0;
+      put(&length, sizeof(length));
+      put(name.data(), length);
+      put(&dtype, sizeof(dtype));
+      flush();
+      this->count_offset = std::ftell(this->file);
+      put(&zero, sizeof(zero));
+    }
+  }
+
+  void write_chunk(const double *values, size_t n) {
+    if (!this->file)
+      return;
+
+    if (this->format == BINARY) {
+      put(values, n * sizeof(double));
+    } else {
+      // "%g" is what operator<< printed with the default precision.
+      char text[32];
+      for (size_t i = 0; i < n; i++) {
+        int length = std::snprintf(text, sizeof(text),
+                                   this->count + i == 0 ? "%g" : ", %g",
+                                   values[i]);
+        put(text, length);
+      }
+    }
+    this->count += n;
+  }
+
+  void end_series() {
+    if (!this->file)
+      return;
+
+    if (this->format == BINARY)
+      patch(this->count_offset, &this->count, sizeof(this->count));
+    else
+      put("\n", 1);
+    this->series++;
+  }
+
+  // Whole series in one go, as before.
+  void append(std::vector<double> data) {
+    begin_series("");
+    write_chunk(data.data(), data.size());
+    end_series();
+  }
+
+  void write() {
+    open();
+    close();
+  }
+
+  void close() {
+    if (!this->file)
+      return;
+
+    if (this->format == BINARY)
+      patch(8 + sizeof(uint32_t), &this->series, sizeof(this->series));
+    flush();
+    int closed = std::fclose(this->file);
+    this->file = nullptr;
+    NS_ABORT_MSG_IF(closed != 0, "File_writer: cannot write " << this->path);
+  }
+};
+
+#endif /* FILE_WRITER_H */
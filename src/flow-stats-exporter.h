@@ -0,0 +1,127 @@
+#ifndef FLOW_STATS_EXPORTER_H
+#define FLOW_STATS_EXPORTER_H
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/internet-module.h"
+
+namespace ns3 {
+
+// Writes what a FlowMonitor counted in each interval as CSV, one line per
+// flow that changed:
+//
+//   time,flow,src,dst,protocol,src_port,dst_port,tx_packets,tx_bytes,
+//   rx_packets,rx_bytes,delay_sum,jitter_sum,lost_packets
+//
+// time is the end of the interval and the counters are what was added
+// during it, delay_sum and jitter_sum in seconds. Summing a flow's lines
+// gives its totals, and a line's packets and bytes over the interval give
+// its throughput.
+//
+// Snapshots are taken at start + k * interval, like QueueMonitor sampling,
+// for times before stop; Finish() writes the last, partial interval after
+// the run. Besides the monitor's own per-flow state the exporter keeps one
+// set of counters per flow, so memory does not grow with the run length.
+class FlowStatsExporter : public SimpleRefCount<FlowStatsExporter> {
+public:
+  FlowStatsExporter(Ptr<FlowMonitor> monitor,
+                    Ptr<Ipv4FlowClassifier> classifier, std::string filename)
+      : m_monitor(monitor), m_classifier(classifier) {
+    m_file = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_IF(!m_file, "FlowStatsExporter: cannot open " << filename);
+    std::fprintf(m_file, "time,flow,src,dst,protocol,src_port,dst_port,"
+                         "tx_packets,tx_bytes,rx_packets,rx_bytes,delay_sum,"
+                         "jitter_sum,lost_packets\n");
+  }
+
+  ~FlowStatsExporter() { std::fclose(m_file); }
+
+  void Start(Time start, Time interval, Time stop) {
+    NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(),
+                    "FlowStatsExporter: interval must be positive");
+    m_start = start;
+    m_interval = interval;
+    m_stop = stop;
+    if (start < stop)
+      Simulator::Schedule(start - Simulator::Now(), &FlowStatsExporter::Export,
+                          this, 0);
+  }
+
+  void Finish() {
+    Snapshot();
+    std::fflush(m_file);
+  }
+
+private:
+  struct Counters {
+    Counters()
+        : txPackets(0), txBytes(0), rxPackets(0), rxBytes(0), lostPackets(0) {
+    }
+    uint64_t txPackets, txBytes, rxPackets, rxBytes, lostPackets;
+    Time delaySum, jitterSum;
+  };
+
+  void Export(uint64_t k) {
+    Snapshot();
+    Time next = m_start + m_interval * (int64_t)(k + 1);
+    if (next < m_stop)
+      Simulator::Schedule(next - Simulator::Now(), &FlowStatsExporter::Export,
+                          this, k + 1);
+  }
+
+  void Snapshot() {
+    m_monitor->CheckForLostPackets();
+    double now = Simulator::Now().GetSeconds();
+    const FlowMonitor::FlowStatsContainer &stats = m_monitor->GetFlowStats();
+    for (FlowMonitor::FlowStatsContainer::const_iterator it = stats.begin();
+         it != stats.end(); ++it) {
+      const FlowMonitor::FlowStats &flow = it->second;
+      Counters &last = m_last[it->first];
+      if (flow.txPackets == last.txPackets &&
+          flow.rxPackets == last.rxPackets &&
+          flow.lostPackets == last.lostPackets)
+        continue;
+
+      Ipv4FlowClassifier::FiveTuple t = m_classifier->FindFlow(it->first);
+      uint32_t src = t.sourceAddress.Get(), dst = t.destinationAddress.Get();
+      std::fprintf(
+          m_file,
+          "%.9g,%u,%u.%u.%u.%u,%u.%u.%u.%u,%u,%u,%u,%llu,%llu,%llu,%llu,"
+          "%.9g,%.9g,%llu\n",
+          now, (unsigned)it->first, src >> 24, (src >> 16) & 255,
+          (src >> 8) & 255, src & 255, dst >> 24, (dst >> 16) & 255,
+          (dst >> 8) & 255, dst & 255, (unsigned)t.protocol,
+          (unsigned)t.sourcePort, (unsigned)t.destinationPort,
+          (unsigned long long)(flow.txPackets - last.txPackets),
+          (unsigned long long)(flow.txBytes - last.txBytes),
+          (unsigned long long)(flow.rxPackets - last.rxPackets),
+          (unsigned long long)(flow.rxBytes - last.rxBytes),
+          (flow.delaySum - last.delaySum).GetSeconds(),
+          (flow.jitterSum - last.jitterSum).GetSeconds(),
+          (unsigned long long)(flow.lostPackets - last.lostPackets));
+
+      last.txPackets = flow.txPackets;
+      last.txBytes = flow.txBytes;
+      last.rxPackets = flow.rxPackets;
+      last.rxBytes = flow.rxBytes;
+      last.lostPackets = flow.lostPackets;
+      last.delaySum = flow.delaySum;
+      last.jitterSum = flow.jitterSum;
+    }
+  }
+
+  Ptr<FlowMonitor> m_monitor;
+  Ptr<Ipv4FlowClassifier> m_classifier;
+  std::FILE *m_file;
+  Time m_start, m_interval, m_stop;
+  std::map<FlowId, Counters> m_last;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_STATS_EXPORTER_H */
@@ -0,0 +1,157 @@
+#ifndef FLOW_TALLY_H
+#define FLOW_TALLY_H
+
+#include <cstdint>
+#include <ostream>
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+#include <mpi.h>
+#endif
+
+namespace ns3 {
+
+// Send time of a packet, attached where it enters IPv4.
+class FlowTallyTag : public Tag {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid = TypeId("ns3::FlowTallyTag")
+                            .SetParent<Tag>()
+                            .AddConstructor<FlowTallyTag>();
+    return tid;
+  }
+
+  FlowTallyTag() : m_sent(0) {}
+  FlowTallyTag(Time sent) : m_sent(sent.GetTimeStep()) {}
+
+  Time GetSent() const { return TimeStep(m_sent); }
+
+  virtual TypeId GetInstanceTypeId() const { return GetTypeId(); }
+  virtual uint32_t GetSerializedSize() const { return 8; }
+  virtual void Serialize(TagBuffer buffer) const { buffer.WriteU64(m_sent); }
+  virtual void Deserialize(TagBuffer buffer) { m_sent = buffer.ReadU64(); }
+  virtual void Print(std::ostream &os) const { os << "sent=" << m_sent; }
+
+private:
+  int64_t m_sent;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(FlowTallyTag);
+
+// End-to-end packet, loss and delay totals over all IPv4 traffic, the
+// numbers RunSummary reports. FlowMonitor keeps the send time of each
+// packet in the monitor, so it cannot match a packet received on another
+// MPI rank to its send. The tally carries the send time in a packet tag,
+// which is serialized with the packet when it crosses ranks, so each rank
+// counts what its own nodes send, receive and drop and GetTotals() adds
+// the ranks up.
+//
+// Like FlowMonitor, a packet is sent when a node originates it, received
+// when it is delivered locally, and lost when IPv4, a queue disc or a
+// device queue drops it.
+class FlowTally {
+public:
+  struct Totals {
+    uint64_t txPackets;
+    uint64_t rxPackets;
+    uint64_t lostPackets;
+    uint64_t delaySum; // time steps
+  };
+
+  FlowTally() : m_totals() {}
+
+  // Installs on the given nodes; in a distributed run, the local ones. Call
+  // it after the queue discs are in place.
+  void Install(NodeContainer nodes) {
+    for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+      Ptr<Node> node = nodes.Get(i);
+      Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol>();
+      NS_ABORT_MSG_IF(!ipv4, "FlowTally: node without IPv4");
+      ipv4->TraceConnectWithoutContext(
+          "SendOutgoing", MakeCallback(&FlowTally::Sent, this));
+      ipv4->TraceConnectWithoutContext(
+          "LocalDeliver", MakeCallback(&FlowTally::Received, this));
+      ipv4->TraceConnectWithoutContext(
+          "Drop", MakeCallback(&FlowTally::IpDropped, this));
+
+      Ptr<TrafficControlLayer> tc = node->GetObject<TrafficControlLayer>();
+      for (uint32_t d = 0; d < node->GetNDevices(); ++d) {
+        Ptr<NetDevice> device = node->GetDevice(d);
+        PointerValue queue;
+        if (device->GetAttributeFailSafe("TxQueue", queue) &&
+            queue.Get<QueueBase>())
+          queue.Get<QueueBase>()->TraceConnectWithoutContext(
+              "Drop", MakeCallback(&FlowTally::Dropped, this));
+        Ptr<QueueDisc> qdisc = tc ? tc->GetRootQueueDiscOnDevice(device) : 0;
+        if (qdisc)
+          qdisc->TraceConnectWithoutContext(
+              "Drop", MakeCallback(&FlowTally::QueueDiscDropped, this));
+      }
+    }
+  }
+
+  // The totals over all ranks. In a distributed run every rank has to call
+  // this, as it is a collective operation.
+  Totals GetTotals() const {
+    Totals totals = m_totals;
+#ifdef NS3_MPI
+    if (MpiInterface::IsEnabled()) {
+      uint64_t local[4] = {m_totals.txPackets, m_totals.rxPackets,
+                           m_totals.lostPackets, m_totals.delaySum};
+      uint64_t global[4];
+      MPI_Allreduce(local, global, 4, MPI_UNSIGNED_LONG_LONG, MPI_SUM,
+                    MPI_COMM_WORLD);
+      totals.txPackets = global[0];
+      totals.rxPackets = global[1];
+      totals.lostPackets = global[2];
+      totals.delaySum = global[3];
+    }
+#endif
+    return totals;
+  }
+
+private:
+  void Sent(const Ipv4Header &header, Ptr<const Packet> packet,
+            uint32_t interface) {
+    FlowTallyTag tag(Simulator::Now());
+    ConstCast<Packet>(packet)->ReplacePacketTag(tag);
+    m_totals.txPackets++;
+  }
+
+  void Received(const Ipv4Header &header, Ptr<const Packet> packet,
+                uint32_t interface) {
+    FlowTallyTag tag;
+    if (!packet->PeekPacketTag(tag))
+      return;
+    m_totals.rxPackets++;
+    m_totals.delaySum += (Simulator::Now() - tag.GetSent()).GetTimeStep();
+  }
+
+  // Untags the packet so that a later report of the same loss is ignored.
+  void Dropped(Ptr<const Packet> packet) {
+    FlowTallyTag tag;
+    if (ConstCast<Packet>(packet)->RemovePacketTag(tag))
+      m_totals.lostPackets++;
+  }
+
+  void IpDropped(const Ipv4Header &header, Ptr<const Packet> packet,
+                 Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4,
+                 uint32_t interface) {
+    Dropped(packet);
+  }
+
+  void QueueDiscDropped(Ptr<const QueueDiscItem> item) {
+    Dropped(item->GetPacket());
+  }
+
+  Totals m_totals;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_TALLY_H */
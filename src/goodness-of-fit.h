@@ -0,0 +1,245 @@
+#ifndef GOODNESS_OF_FIT_H
+#define GOODNESS_OF_FIT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Streaming goodness-of-fit checks for the part1 generators.
+//
+// Every value is mapped through the target CDF, u = F(x), and only fixed-size
+// state is kept, so any number of samples can be checked in constant memory:
+//
+//  - a fine histogram of u (fine_bins cells), from which
+//    * chi-square uses chi_bins equiprobable cells, and
+//    * Kolmogorov-Smirnov is bracketed: D_low is the exact deviation at the
+//      cell edges, D_high additionally allows the worst case inside a cell,
+//      so D_low <= D <= D_high and D_high - D_low <= 1 / fine_bins. The KS
+//      p-value is computed from D_high, i.e. conservatively;
+//  - running sums for the lag-1 serial correlation (Knuth 3.3.2 K);
+//  - gap lengths between visits to [0, gap_beta), counted up to gap_max
+//    (Knuth 3.3.2 B).
+
+// The distribution the samples are supposed to follow.
+struct Gof_target {
+  enum Kind { UNIFORM, EXPONENTIAL };
+
+  Kind kind;
+  double a, b; // UNIFORM: [a, b). EXPONENTIAL: mean a, truncated at b (0: none)
+
+  static Gof_target uniform(double min, double max) {
+    Gof_target t = {UNIFORM, min, max};
+    return t;
+  }
+
+  static Gof_target exponential(double mean, double bound = 0) {
+    Gof_target t = {EXPONENTIAL, mean, bound};
+    return t;
+  }
+
+  double cdf(double x) const {
+    if (kind == UNIFORM)
+      return x <= a ? 0 : x >= b ? 1 : (x - a) / (b - a);
+
+    if (x <= 0)
+      return 0;
+    double mass = b > 0 ? -std::expm1(-b / a) : 1.0;
+    double u = -std::expm1(-x / a) / mass;
+    return u < 1 ? u : 1;
+  }
+};
+
+// Regularised upper incomplete gamma Q(s, x), for chi-square p-values
+// (Numerical Recipes 6.2: series below s + 1, continued fraction above).
+inline double gof_gamma_q(double s, double x) {
+  if (x <= 0)
+    return 1;
+
+  double lg = std::lgamma(s);
+  if (x < s + 1) {
+    double term = 1 / s, sum = term;
+    for (int i = 1; i < 1000 && std::fabs(term) > std::fabs(sum) * 1e-15;
+         i++) {
+      term *= x / (s + i);
+      sum += term;
+    }
+    return 1 - sum * std::exp(-x + s * std::log(x) - lg);
+  }
+
+  double tiny = 1e-300;
+  double b = x + 1 - s, c = 1 / tiny, d = 1 / b, h = d;
+  for (int i = 1; i < 1000; i++) {
+    double an = -i * (i - s);
+    b += 2;
+    d = an * d + b;
+    d = std::fabs(d) < tiny ? tiny : d;
+    c = b + an / c;
+    c = std::fabs(c) < tiny ? tiny : c;
+    d = 1 / d;
+    double delta = d * c;
+    h *= delta;
+    if (std::fabs(delta - 1) < 1e-15)
+      break;
+  }
+  return std::exp(-x + s * std::log(x) - lg) * h;
+}
+
+inline double gof_chi2_p(double chi2, double df) {
+  return gof_gamma_q(df / 2, chi2 / 2);
+}
+
+// P(D_n > d) with Stephens' small-sample correction.
+inline double gof_ks_p(double d, double n) {
+  double sn = std::sqrt(n);
+  double lambda = (sn + 0.12 + 0.11 / sn) * d;
+  if (lambda < 0.2)
+    return 1;
+
+  double sum = 0, sign = 1;
+  for (int k = 1; k <= 100; k++) {
+    double term = std::exp(-2 * k * k * lambda * lambda);
+    sum += sign * term;
+    if (term < 1e-16)
+      break;
+    sign = -sign;
+  }
+  double p = 2 * sum;
+  return p < 0 ? 0 : p > 1 ? 1 : p;
+}
+
+class Gof_stream {
+public:
+  static const int fine_bins = 1 << 16;
+  static const int chi_bins = 64;
+  static const int gap_max = 16;
+
+  explicit Gof_stream(Gof_target target, double gap_beta = 0.5)
+      : target(target), fine(fine_bins, 0), gaps(gap_max + 1, 0),
+        gap_beta(gap_beta), n(0), sum(0), sum_sq(0), sum_lag(0), first(0),
+        previous(0), gap(0) {}
+
+  void add(const double *x, std::size_t k) {
+    for (std::size_t i = 0; i < k; i++) {
+      double u = target.cdf(x[i]);
+
+      int cell = (int)(u * fine_bins);
+      fine[cell < fine_bins ? cell : fine_bins - 1]++;
+
+      if (n == 0)
+        first = u;
+      else
+        sum_lag += previous * u;
+      sum += u;
+      sum_sq += u * u;
+      previous = u;
+      n++;
+
+      if (u < gap_beta) {
+        gaps[gap < gap_max ? gap : gap_max]++;
+        gap = 0;
+      } else {
+        gap++;
+      }
+    }
+  }
+
+  uint64_t count() const { return n; }
+
+  struct Report {
+    uint64_t n;
+    double chi2, chi2_df, chi2_p;
+    double ks_low, ks_high, ks_p;
+    double serial_r, serial_z;
+    double gap_chi2, gap_df, gap_p;
+  };
+
+  Report report() const {
+    Report r = Report();
+    r.n = n;
+    if (n < 2)
+      return r;
+
+    // Chi-square over equiprobable cells.
+    const int per_cell = fine_bins / chi_bins;
+    double expected = (double)n / chi_bins;
+    for (int c = 0; c < chi_bins; c++) {
+      uint64_t observed = 0;
+      for (int j = 0; j < per_cell; j++)
+        observed += fine[c * per_cell + j];
+      r.chi2 += (observed - expected) * (observed - expected) / expected;
+    }
+    r.chi2_df = chi_bins - 1;
+    r.chi2_p = gof_chi2_p(r.chi2, r.chi2_df);
+
+    // KS bracket from the cell edges.
+    uint64_t below = 0;
+    for (int c = 0; c < fine_bins; c++) {
+      double lo = (double)c / fine_bins, hi = (double)(c + 1) / fine_bins;
+      double f_lo = (double)below / n;
+      below += fine[c];
+      double f_hi = (double)below / n;
+
+      r.ks_low = std::max(r.ks_low, std::fabs(f_hi - hi));
+      r.ks_high = std::max(r.ks_high, std::max(f_hi - lo, hi - f_lo));
+    }
+    r.ks_p = gof_ks_p(r.ks_high, (double)n);
+
+    // Serial correlation, circular as in Knuth so the formula stays exact.
+    double nn = (double)n;
+    double lag = sum_lag + previous * first;
+    double denominator = nn * sum_sq - sum * sum;
+    r.serial_r = denominator > 0 ? (nn * lag - sum * sum) / denominator : 0;
+    double mu = -1 / (nn - 1);
+    double sigma = std::sqrt(nn * nn / ((nn - 1) * (nn - 1) * (nn - 2)));
+    r.serial_z = n > 2 ? (r.serial_r - mu) / sigma : 0;
+
+    // Gap test against the geometric distribution.
+    uint64_t total = 0;
+    for (int g = 0; g <= gap_max; g++)
+      total += gaps[g];
+    double p = gap_beta, q = 1 - p;
+    for (int g = 0; g <= gap_max && total > 0; g++) {
+      double prob = g < gap_max ? p * std::pow(q, g) : std::pow(q, gap_max);
+      double e = total * prob;
+      if (e > 0)
+        r.gap_chi2 += (gaps[g] - e) * (gaps[g] - e) / e;
+    }
+    r.gap_df = gap_max;
+    r.gap_p = total > 0 ? gof_chi2_p(r.gap_chi2, r.gap_df) : 1;
+
+    return r;
+  }
+
+  static std::string header() {
+    return "series n chi2 chi2_df chi2_p ks_d_low ks_d_high ks_p serial_r "
+           "serial_z gap_chi2 gap_df gap_p";
+  }
+
+  std::string line(const std::string &series) const {
+    Report r = report();
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "%s %llu %.6g %g %.4g %.6g %.6g %.4g %.6g %.4g %.6g %g %.4g",
+                  series.c_str(), (unsigned long long)r.n, r.chi2, r.chi2_df,
+                  r.chi2_p, r.ks_low, r.ks_high, r.ks_p, r.serial_r,
+                  r.serial_z, r.gap_chi2, r.gap_df, r.gap_p);
+    return text;
+  }
+
+private:
+  Gof_target target;
+  std::vector<uint64_t> fine;
+  std::vector<uint64_t> gaps;
+  double gap_beta;
+
+  uint64_t n;
+  double sum, sum_sq, sum_lag;
+  double first, previous;
+  int gap;
+};
+
+#endif /* GOODNESS_OF_FIT_H */
@@ -0,0 +1,114 @@
+#ifndef INVERSE_TRANSFORM_H
+#define INVERSE_TRANSFORM_H
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// In-place inverse-CDF kernels: each one overwrites a span of uniforms in
+// (0, 1] with the corresponding variates. Nothing is allocated or copied.
+//
+// The exponential family only needs log(u). fast_log_inplace() computes it
+// without calling libm so the loop can be vectorised:
+//
+//   u = 2^e * m, m in [sqrt(1/2), sqrt(2))
+//   log(u) = e * ln2 + 2 * atanh(s), s = (m - 1) / (m + 1), |s| < 0.1716
+//
+// and atanh is summed up to s^13. The truncation error is below
+// 2 * 0.1716^15 / 15 < 5e-13, so for every normal u
+//
+//   |fast_log(u) - log(u)| <= 1e-12
+//
+// which is far below the 6 significant digits written to the CSV output.
+// Zero, subnormal, negative and non-finite inputs fall back to std::log.
+// Pass exact = true to skip the approximation and use std::log throughout.
+
+inline void fast_log_inplace(double *x, std::size_t n) {
+  const double ln2 = 0.693147180559945309417232121458;
+  // Bit pattern of sqrt(1/2), and the offset that moves it onto 1.0.
+  const uint64_t low = 0x3fe6a09e667f3bcdULL;
+  const uint64_t shift = 0x3ff0000000000000ULL - low;
+
+  for (std::size_t i = 0; i < n; i++) {
+    uint64_t bits;
+    std::memcpy(&bits, &x[i], sizeof(bits));
+
+    // Split into 2^e * m with m in [sqrt(1/2), sqrt(2)) using integer ops
+    // only, so the loop has no branches or selects.
+    uint64_t t = bits + shift;
+    int32_t e = (int32_t)(t >> 52) - 1023;
+    uint64_t mbits = (t & 0x000fffffffffffffULL) + low;
+    double m;
+    std::memcpy(&m, &mbits, sizeof(m));
+
+    double s = (m - 1.0) / (m + 1.0);
+    double s2 = s * s;
+    double p = 1.0 / 13;
+    p = p * s2 + 1.0 / 11;
+    p = p * s2 + 1.0 / 9;
+    p = p * s2 + 1.0 / 7;
+    p = p * s2 + 1.0 / 5;
+    p = p * s2 + 1.0 / 3;
+    p = p * s2 + 1.0;
+
+    x[i] = (double)e * ln2 + 2.0 * s * p;
+  }
+}
+
+// Inputs fast_log_inplace() does not handle, recomputed from the originals.
+// Kept out of the main loop so that one stays branch-free.
+inline void log_fixup(const double *in, double *out, std::size_t n) {
+  for (std::size_t i = 0; i < n; i++) {
+    if (!(in[i] >= DBL_MIN && in[i] <= DBL_MAX))
+      out[i] = std::log(in[i]);
+  }
+}
+
+// u -> -log(u) / lambda, exponential with rate lambda.
+inline void exponential_inplace(double *u, std::size_t n, double lambda,
+                                bool exact = false) {
+  if (exact) {
+    for (std::size_t i = 0; i < n; i++)
+      u[i] = -((std::log(u[i])) / lambda);
+    return;
+  }
+
+  // Process in blocks so the originals for the fixup pass stay on the stack.
+  const std::size_t block = 256;
+  double saved[block];
+  double scale = -1.0 / lambda;
+
+  for (std::size_t start = 0; start < n; start += block) {
+    std::size_t k = n - start < block ? n - start : block;
+    double *x = u + start;
+
+    std::memcpy(saved, x, k * sizeof(double));
+    fast_log_inplace(x, k);
+    log_fixup(saved, x, k);
+    for (std::size_t i = 0; i < k; i++)
+      x[i] *= scale;
+  }
+}
+
+// u -> exponential with the given mean, truncated to [0, bound]:
+// -mean * log(1 - u * (1 - exp(-bound / mean))). bound = 0 means no bound.
+inline void truncated_exponential_inplace(double *u, std::size_t n,
+                                          double mean, double bound,
+                                          bool exact = false) {
+  double mass = bound > 0 ? -std::expm1(-bound / mean) : 1.0;
+
+  for (std::size_t i = 0; i < n; i++)
+    u[i] = 1.0 - u[i] * mass;
+  exponential_inplace(u, n, 1.0 / mean, exact);
+}
+
+// Any other inverse CDF, applied element by element.
+template <class Inverse_cdf>
+void inverse_transform_inplace(double *u, std::size_t n, Inverse_cdf inverse) {
+  for (std::size_t i = 0; i < n; i++)
+    u[i] = inverse(u[i]);
+}
+
+#endif /* INVERSE_TRANSFORM_H */
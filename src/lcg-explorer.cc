@@ -0,0 +1,275 @@
+#include "ns3/core-module.h"
+
+#include "lcg-spectral.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Searches LCG parameters for the ones that pass the spectral test best,
+// where project-part1 -lcg tries one (a, c, m) at a time.
+//
+// Every multiplier in -a (a comma separated list of values and lo-hi
+// ranges, every a from 2 to m - 1 by default) is tried with every modulus
+// in -m, in parallel on -threads cores. The checks get more expensive down
+// the list, and a candidate goes no further than the first it fails (see
+// lcg-spectral.h):
+//
+//  1. the period, analytically: with -fullPeriod (the default) some
+//     increment in -c has to give the longest period there is for m;
+//  2. the spectral test in dimensions 2 to -dims, stopping at the first
+//     S_t below -minMerit or below every multiplier already in the table;
+//  3. for the table only, the pairs chi-square on -screen values.
+//
+// The spectral test depends on a and m only, so each multiplier appears
+// once, with the first increment of -c that gives it the full period. The
+// -top best by merit = min S_t are printed, and written to -output if set:
+//
+//   rank m a c period S2 ... S<dims> merit screen_p
+//
+// With -fullPeriod and no c = 0 in -c, only the multipliers with a - 1 a
+// multiple of every prime factor of m are visited at all, so e.g.
+//
+//   ./waf --run "lcg-explorer --m=4294967296 --a=1-4294967295 --dims=6"
+//
+// looks at 2^30 multipliers rather than 2^32.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("LcgExplorer");
+
+struct Candidate {
+  uint64_t m, a, c, period;
+  double merit;                    // min S_t
+  double s[Lcg_spectral::max_dim]; // S_2.. at s[0]..
+  double screen;
+};
+
+static bool better(const Candidate &x, const Candidate &y) {
+  return x.merit > y.merit || (x.merit == y.merit && x.a < y.a);
+}
+
+// "5,10-20,2^31" as [lo, hi] intervals.
+static std::vector<std::pair<uint64_t, uint64_t>> parse_ranges(
+    std::string list) {
+  std::vector<std::pair<uint64_t, uint64_t>> ranges;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (item.empty())
+      continue;
+    std::string::size_type dash = item.find('-', 1);
+    std::string lo = item.substr(0, dash);
+    std::string hi = dash == std::string::npos ? lo : item.substr(dash + 1);
+    auto value = [](std::string text) {
+      std::string::size_type caret = text.find('^');
+      if (caret == std::string::npos)
+        return (uint64_t)std::stoull(text);
+      uint64_t base = std::stoull(text.substr(0, caret)), v = 1;
+      for (int e = std::stoi(text.substr(caret + 1)); e > 0; e--)
+        v *= base;
+      return v;
+    };
+    ranges.push_back(std::make_pair(value(lo), value(hi)));
+  }
+  return ranges;
+}
+
+// A run of multipliers first, first + stride, ... for one modulus.
+struct Segment {
+  std::size_t modulus;
+  uint64_t first, stride, count;
+};
+
+int main(int argc, char *argv[]) {
+  std::string moduli = "100";
+  std::string multipliers;
+  std::string increments = "1";
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  int dims = 8;
+  double min_merit = 0;
+  int top = 50;
+  bool full_period = true;
+  int screen = 1 << 15;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue("m", "Moduli, e.g. 100,1000-1100,2^31", moduli);
+  cmd.AddValue("a", "Multipliers, every one from 2 to m - 1 if empty",
+               multipliers);
+  cmd.AddValue("c", "Increments, the first that qualifies is reported",
+               increments);
+  cmd.AddValue("threads", "Worker threads", threads);
+  cmd.AddValue("dims", "Highest dimension of the spectral test, 2 to 8",
+               dims);
+  cmd.AddValue("minMerit", "Drop candidates with some S_t below this",
+               min_merit);
+  cmd.AddValue("top", "Rows in the table", top);
+  cmd.AddValue("fullPeriod", "Only candidates with the longest period",
+               full_period);
+  cmd.AddValue("screen", "Values for the pairs chi-square, 0 for none",
+               screen);
+  cmd.AddValue("output", "Also write the table to this file", output);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(dims < 2 || dims > Lcg_spectral::max_dim,
+                  "lcg-explorer: dims must be 2 to 8");
+  NS_ABORT_MSG_IF(top < 1 || threads < 1,
+                  "lcg-explorer: top and threads must be positive");
+
+  std::vector<Lcg_modulus> mods;
+  for (auto range : parse_ranges(moduli)) {
+    for (uint64_t m = range.first; m <= range.second && m >= range.first;
+         m++) {
+      NS_ABORT_MSG_IF(m < 2 || m >> 63,
+                      "lcg-explorer: m must be 2 to 2^63 - 1, got " << m);
+      mods.push_back(Lcg_modulus(m));
+    }
+  }
+  std::vector<uint64_t> cs;
+  for (auto range : parse_ranges(increments))
+    for (uint64_t c = range.first; c <= range.second && c >= range.first;
+         c++)
+      cs.push_back(c);
+  NS_ABORT_MSG_IF(mods.empty() || cs.empty(),
+                  "lcg-explorer: no moduli or no increments");
+  bool with_zero = std::find(cs.begin(), cs.end(), 0) != cs.end();
+
+  // The multipliers to visit, clipped to [1, m - 1]. With the full period
+  // required of nonzero increments, only a = 1 mod step can have it.
+  std::vector<Segment> segments;
+  uint64_t total = 0;
+  for (std::size_t i = 0; i < mods.size(); i++) {
+    uint64_t m = mods[i].m;
+    auto ranges = multipliers.empty()
+                      ? std::vector<std::pair<uint64_t, uint64_t>>(
+                            1, std::make_pair(2, m - 1))
+                      : parse_ranges(multipliers);
+    for (auto range : ranges) {
+      uint64_t lo = std::max<uint64_t>(range.first, 1);
+      uint64_t hi = std::min(range.second, m - 1);
+      if (lo > hi)
+        continue;
+      Segment s = {i, lo, 1, 0};
+      if (full_period && !with_zero) {
+        s.stride = mods[i].step;
+        uint64_t offset = (lo + s.stride - 1) % s.stride;
+        s.first = offset ? lo + s.stride - offset : lo;
+        if (s.first > hi || s.first < lo)
+          continue;
+      }
+      s.count = (hi - s.first) / s.stride + 1;
+      segments.push_back(s);
+      total += s.count;
+    }
+  }
+
+  // Workers take chunks of the multipliers in order and keep their own
+  // best; the top-th best so far is the bar the next ones have to clear.
+  const uint64_t chunk = 1024;
+  std::atomic<uint64_t> next(0);
+  std::atomic<uint64_t> full(0);
+  std::vector<std::vector<Candidate>> kept(threads);
+  auto work = [&](int id) {
+    Lcg_spectral spectral;
+    std::vector<Candidate> &best = kept[id];
+    double bar = min_merit;
+    // Chunks are handed out in increasing order, so the segment a worker
+    // is in only moves forward.
+    std::size_t segment = 0;
+    uint64_t before = 0; // multipliers in the segments before `segment`
+    uint64_t found = 0;
+    for (uint64_t start; (start = next.fetch_add(chunk)) < total;) {
+      for (uint64_t k = start; k < std::min(start + chunk, total); k++) {
+        while (k >= before + segments[segment].count)
+          before += segments[segment++].count;
+        const Segment &s = segments[segment];
+        const Lcg_modulus &mod = mods[s.modulus];
+
+        Candidate x = Candidate();
+        x.m = mod.m;
+        x.a = s.first + (k - before) * s.stride;
+        for (uint64_t c : cs) {
+          if (c >= x.m)
+            continue;
+          x.period = mod.period(x.a, c);
+          x.c = c;
+          if (x.period || !full_period)
+            break;
+        }
+        found += x.period != 0;
+        if (full_period && !x.period)
+          continue;
+
+        x.merit = 1;
+        for (int t = 2; t <= dims && x.merit >= bar; t++) {
+          x.s[t - 2] = spectral.merit(x.a, x.m, t);
+          x.merit = std::min(x.merit, x.s[t - 2]);
+        }
+        if (x.merit < bar)
+          continue;
+
+        best.push_back(x);
+        if (best.size() >= 2 * (std::size_t)top) {
+          std::nth_element(best.begin(), best.begin() + top - 1, best.end(),
+                           better);
+          best.resize(top);
+          bar = std::max(bar, best[top - 1].merit);
+        }
+      }
+    }
+    full += found;
+  };
+
+  auto started = std::chrono::steady_clock::now();
+  std::vector<std::thread> pool;
+  for (int t = 1; t < threads; t++)
+    pool.push_back(std::thread(work, t));
+  work(0);
+  for (std::thread &t : pool)
+    t.join();
+
+  std::vector<Candidate> table;
+  for (const std::vector<Candidate> &best : kept)
+    table.insert(table.end(), best.begin(), best.end());
+  std::sort(table.begin(), table.end(), better);
+  if (table.size() > (std::size_t)top)
+    table.resize(top);
+  for (Candidate &x : table)
+    x.screen = screen > 0 ? lcg_pairs_screen(x.a, x.c, x.m, 1, screen) : NAN;
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - started)
+                       .count();
+
+  std::FILE *file = output.empty() ? nullptr : std::fopen(output.c_str(), "w");
+  NS_ABORT_MSG_IF(!output.empty() && !file,
+                  "lcg-explorer: cannot open " << output);
+  for (std::FILE *out : {stdout, file}) {
+    if (!out)
+      continue;
+    std::fprintf(out, "rank m a c period");
+    for (int t = 2; t <= dims; t++)
+      std::fprintf(out, " S%d", t);
+    std::fprintf(out, " merit screen_p\n");
+    for (std::size_t r = 0; r < table.size(); r++) {
+      const Candidate &x = table[r];
+      std::fprintf(out, "%zu %llu %llu %llu %llu", r + 1,
+                   (unsigned long long)x.m, (unsigned long long)x.a,
+                   (unsigned long long)x.c, (unsigned long long)x.period);
+      for (int t = 2; t <= dims; t++)
+        std::fprintf(out, " %.4f", x.s[t - 2]);
+      std::fprintf(out, " %.4f %.4g\n", x.merit, x.screen);
+    }
+  }
+  if (file)
+    std::fclose(file);
+  std::fprintf(stderr, "%llu multipliers, %llu with the longest period, "
+               "in %.1f s\n", (unsigned long long)total,
+               (unsigned long long)full.load(), seconds);
+  return 0;
+}
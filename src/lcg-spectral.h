@@ -0,0 +1,367 @@
+#ifndef LCG_SPECTRAL_H
+#define LCG_SPECTRAL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "goodness-of-fit.h"
+#include "lcg.h"
+
+// Quality checks for LCG parameters (a, c, m), for lcg-explorer.cc:
+//
+//  - the period, from the number theory alone (Knuth 3.2.1.2): with c != 0
+//    it is m iff gcd(c, m) = 1, a - 1 is a multiple of every prime dividing
+//    m, and of 4 if 4 divides m. With c = 0 the best there is is m - 1 for
+//    a prime m and a primitive root a, or m / 4 for m = 2^k and
+//    a = 3 or 5 mod 8;
+//  - the spectral test (Knuth 3.3.4): the t-tuples of successive values lie
+//    on parallel hyperplanes 1 / nu_t apart, nu_t being the length of the
+//    shortest nonzero s with s_1 + a s_2 + ... + a^(t-1) s_t = 0 mod m. That
+//    is the shortest vector of a lattice of determinant m, found here by
+//    LLL reduction and enumeration. The figure of merit
+//    S_t = nu_t / (gamma_t^(1/2) m^(1/t)) divides by the Hermite bound, so
+//    1 is the best any lattice of that determinant can do;
+//  - a quick empirical screen: chi-square of non-overlapping pairs of
+//    successive values over a 16 x 16 grid.
+//
+// Everything works on m below 2^63; the lattice arithmetic is exact in
+// 128-bit integers, the Gram-Schmidt data in long double.
+
+inline uint64_t lcg_mul_mod(uint64_t a, uint64_t b, uint64_t m) {
+  return (uint64_t)((unsigned __int128)a * b % m);
+}
+
+inline uint64_t lcg_pow_mod(uint64_t a, uint64_t e, uint64_t m) {
+  uint64_t r = 1 % m;
+  for (a %= m; e > 0; e >>= 1) {
+    if (e & 1)
+      r = lcg_mul_mod(r, a, m);
+    a = lcg_mul_mod(a, a, m);
+  }
+  return r;
+}
+
+inline uint64_t lcg_gcd(uint64_t a, uint64_t b) {
+  while (b) {
+    uint64_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+// Deterministic Miller-Rabin; these bases cover every 64-bit n.
+inline bool lcg_is_prime(uint64_t n) {
+  if (n < 2)
+    return false;
+  static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+  for (uint64_t p : bases)
+    if (n % p == 0)
+      return n == p;
+  uint64_t d = n - 1;
+  int s = 0;
+  for (; (d & 1) == 0; s++)
+    d >>= 1;
+  for (uint64_t b : bases) {
+    uint64_t x = lcg_pow_mod(b, d, n);
+    if (x == 1 || x == n - 1)
+      continue;
+    bool composite = true;
+    for (int i = 1; i < s && composite; i++) {
+      x = lcg_mul_mod(x, x, n);
+      composite = x != n - 1;
+    }
+    if (composite)
+      return false;
+  }
+  return true;
+}
+
+// A nontrivial factor of a composite n (Pollard's rho, Brent's cycle
+// finding).
+inline uint64_t lcg_rho(uint64_t n) {
+  if (n % 2 == 0)
+    return 2;
+  for (uint64_t c = 1;; c++) {
+    uint64_t x = 2, y = 2, d = 1, power = 1, length = 0;
+    while (d == 1) {
+      if (length == power) {
+        x = y;
+        power *= 2;
+        length = 0;
+      }
+      y = (lcg_mul_mod(y, y, n) + c) % n;
+      length++;
+      d = lcg_gcd(x > y ? x - y : y - x, n);
+    }
+    if (d != n)
+      return d;
+  }
+}
+
+// The distinct primes dividing n, in increasing order.
+inline std::vector<uint64_t> lcg_prime_factors(uint64_t n) {
+  std::vector<uint64_t> primes, stack;
+  for (uint64_t p = 2; p < 1000 && n > 1; p++) {
+    if (n % p)
+      continue;
+    primes.push_back(p);
+    while (n % p == 0)
+      n /= p;
+  }
+  if (n > 1)
+    stack.push_back(n);
+  while (!stack.empty()) {
+    uint64_t k = stack.back();
+    stack.pop_back();
+    if (lcg_is_prime(k)) {
+      primes.push_back(k);
+      continue;
+    }
+    uint64_t d = lcg_rho(k);
+    stack.push_back(d);
+    stack.push_back(k / d);
+  }
+  std::sort(primes.begin(), primes.end());
+  primes.erase(std::unique(primes.begin(), primes.end()), primes.end());
+  return primes;
+}
+
+// What the period conditions need to know about one modulus, worked out
+// once and shared by every (a, c) tried with it.
+struct Lcg_modulus {
+  uint64_t m;
+  uint64_t step;  // a - 1 must be a multiple of this for the full period
+  bool prime;
+  bool power_of_2;
+  std::vector<uint64_t> order_factors; // of m - 1 when m is prime
+
+  explicit Lcg_modulus(uint64_t m)
+      : m(m), step(1), prime(lcg_is_prime(m)),
+        power_of_2((m & (m - 1)) == 0) {
+    for (uint64_t p : lcg_prime_factors(m))
+      step *= p;
+    if (m % 4 == 0 && step % 4 != 0)
+      step *= 2;
+    if (prime)
+      order_factors = lcg_prime_factors(m - 1);
+  }
+
+  // The period from any seed (any odd seed for m = 2^k and c = 0) when it
+  // is the longest possible for this m and c, 0 otherwise.
+  uint64_t period(uint64_t a, uint64_t c) const {
+    if (c != 0)
+      return lcg_gcd(c, m) == 1 && (a + m - 1) % m % step == 0 ? m : 0;
+    if (prime) {
+      if (a % m == 0)
+        return 0;
+      for (uint64_t q : order_factors)
+        if (lcg_pow_mod(a, (m - 1) / q, m) == 1)
+          return 0;
+      return m - 1;
+    }
+    if (power_of_2 && m >= 8)
+      return a % 8 == 3 || a % 8 == 5 ? m / 4 : 0;
+    return 0;
+  }
+};
+
+// gamma_t^(1/2), t = 2..8, the Hermite constants' square roots.
+inline double lcg_hermite_root(int t) {
+  static const double gamma_t[] = {4.0 / 3, 2, 4, 8, 64.0 / 3, 64, 256};
+  return std::sqrt(std::pow(gamma_t[t - 2], 1.0 / t));
+}
+
+// The spectral test of multiplier a mod m in dimensions 2..8.
+class Lcg_spectral {
+public:
+  static const int max_dim = 8;
+
+  // nu_t^2, exactly.
+  unsigned __int128 nu2(uint64_t a, uint64_t m, int t) {
+    this->t = t;
+    // Dual basis: m e_1, and -a^j e_1 + e_(j+1).
+    uint64_t power = 1;
+    for (int i = 0; i < t; i++) {
+      for (int j = 0; j < t; j++)
+        b[i][j] = 0;
+      if (i == 0) {
+        b[0][0] = m;
+      } else {
+        power = lcg_mul_mod(power, a, m);
+        b[i][0] = -(__int128)power;
+        b[i][i] = 1;
+      }
+    }
+    lll();
+    return shortest();
+  }
+
+  // S_t, in (0, 1].
+  double merit(uint64_t a, uint64_t m, int t) {
+    long double nu = std::sqrt((long double)nu2(a, m, t));
+    return (double)(nu / (lcg_hermite_root(t) * std::pow((long double)m,
+                                                          1.0L / t)));
+  }
+
+private:
+  static long double dot(const __int128 *x, const __int128 *y, int t) {
+    long double sum = 0;
+    for (int i = 0; i < t; i++)
+      sum += (long double)x[i] * (long double)y[i];
+    return sum;
+  }
+
+  void gram_schmidt() {
+    for (int i = 0; i < t; i++) {
+      for (int k = 0; k < t; k++)
+        star[i][k] = (long double)b[i][k];
+      for (int j = 0; j < i; j++) {
+        long double d = 0;
+        for (int k = 0; k < t; k++)
+          d += (long double)b[i][k] * star[j][k];
+        mu[i][j] = norm[j] > 0 ? d / norm[j] : 0;
+        for (int k = 0; k < t; k++)
+          star[i][k] -= mu[i][j] * star[j][k];
+      }
+      norm[i] = 0;
+      for (int k = 0; k < t; k++)
+        norm[i] += star[i][k] * star[i][k];
+    }
+  }
+
+  // b_k -= round(mu_kj) b_j, keeping mu in step.
+  void size_reduce(int k, int j) {
+    long double q = std::round(mu[k][j]);
+    if (q == 0)
+      return;
+    __int128 r = (__int128)q;
+    for (int i = 0; i < t; i++)
+      b[k][i] -= r * b[j][i];
+    for (int i = 0; i < j; i++)
+      mu[k][i] -= q * mu[j][i];
+    mu[k][j] -= q;
+  }
+
+  // Swaps b_k and b_(k-1) and updates the Gram-Schmidt data to match
+  // (Cohen, Algorithm 2.6.3).
+  void swap(int k) {
+    for (int i = 0; i < t; i++)
+      std::swap(b[k][i], b[k - 1][i]);
+    for (int j = 0; j < k - 1; j++)
+      std::swap(mu[k][j], mu[k - 1][j]);
+    long double m = mu[k][k - 1];
+    long double joint = norm[k] + m * m * norm[k - 1];
+    mu[k][k - 1] = m * norm[k - 1] / joint;
+    norm[k] = norm[k - 1] * norm[k] / joint;
+    norm[k - 1] = joint;
+    for (int i = k + 1; i < t; i++) {
+      long double old = mu[i][k];
+      mu[i][k] = mu[i][k - 1] - m * old;
+      mu[i][k - 1] = old + mu[k][k - 1] * mu[i][k];
+    }
+  }
+
+  // LLL with delta = 0.99. The Gram-Schmidt data are recomputed at the
+  // end, so the enumeration does not see the rounding of the updates.
+  void lll() {
+    gram_schmidt();
+    int k = 1;
+    while (k < t) {
+      size_reduce(k, k - 1);
+      if (norm[k] < (0.99L - mu[k][k - 1] * mu[k][k - 1]) * norm[k - 1]) {
+        swap(k);
+        k = std::max(k - 1, 1);
+        continue;
+      }
+      for (int j = k - 2; j >= 0; j--)
+        size_reduce(k, j);
+      k++;
+    }
+    gram_schmidt();
+  }
+
+  // Enumerates the x with |sum x_i b_i|^2 < bound, from the last
+  // coordinate down, narrowing bound to every shorter vector found.
+  void enumerate(int level, long double partial) {
+    long double center = 0;
+    for (int j = level + 1; j < t; j++)
+      center -= x[j] * mu[j][level];
+    long double room = (bound - partial) / norm[level];
+    if (room < 0)
+      return;
+    long double half = std::sqrt(room);
+    long double lo = std::ceil(center - half), hi = std::floor(center + half);
+    for (long double v = lo; v <= hi; v++) {
+      x[level] = v;
+      long double length = partial + (v - center) * (v - center) * norm[level];
+      if (length >= bound)
+        continue;
+      if (level > 0) {
+        enumerate(level - 1, length);
+      } else if (length > 0.5L) {
+        bound = length;
+        for (int i = 0; i < t; i++)
+          best[i] = (__int128)x[i];
+      }
+    }
+  }
+
+  unsigned __int128 shortest() {
+    // b_1 is a candidate, and the others only matter if shorter: the
+    // bound is nudged up so rounding cannot lose b_1 itself.
+    for (int i = 0; i < t; i++)
+      best[i] = i == 0;
+    bound = dot(b[0], b[0], t) * (1 + 1e-12L) + 1;
+    for (int i = 0; i < t; i++)
+      x[i] = 0;
+    enumerate(t - 1, 0);
+
+    // The vector itself, in integers, for an exact length.
+    unsigned __int128 length = 0;
+    for (int k = 0; k < t; k++) {
+      __int128 v = 0;
+      for (int i = 0; i < t; i++)
+        v += best[i] * b[i][k];
+      length += (unsigned __int128)(v < 0 ? -v : v) *
+                (unsigned __int128)(v < 0 ? -v : v);
+    }
+    return length;
+  }
+
+  int t;
+  __int128 b[max_dim][max_dim];
+  long double star[max_dim][max_dim], mu[max_dim][max_dim], norm[max_dim];
+  long double x[max_dim], bound;
+  __int128 best[max_dim];
+};
+
+// p-value of the chi-square of n / 2 non-overlapping pairs of successive
+// values on a 16 x 16 grid, NaN when m or n leave fewer than 5 pairs per
+// cell on average.
+inline double lcg_pairs_screen(uint64_t a, uint64_t c, uint64_t m,
+                               uint64_t seed, std::size_t n) {
+  const int grid = 16;
+  std::size_t pairs = std::min<uint64_t>(n, m) / 2;
+  if (pairs < 5 * grid * grid)
+    return NAN;
+  std::vector<double> u(2 * pairs);
+  Lcg_generator((int64_t)a, (int64_t)c, (int64_t)m, (int64_t)seed)
+      .fill(u.data(), u.size());
+
+  uint32_t cells[grid * grid] = {};
+  for (std::size_t i = 0; i < pairs; i++) {
+    int x = std::min((int)(u[2 * i] * grid), grid - 1);
+    int y = std::min((int)(u[2 * i + 1] * grid), grid - 1);
+    cells[x * grid + y]++;
+  }
+  double expected = (double)pairs / (grid * grid), chi2 = 0;
+  for (uint32_t observed : cells)
+    chi2 += (observed - expected) * (observed - expected) / expected;
+  return gof_chi2_p(chi2, grid * grid - 1);
+}
+
+#endif /* LCG_SPECTRAL_H */
@@ -0,0 +1,230 @@
+#ifndef LCG_H
+#define LCG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// Linear congruential generator x' = (a * x + c) mod m.
+//
+// The modulus policies below only differ in how they keep a * x + c from
+// overflowing before the reduction; every operand handed to them is already
+// reduced into [0, m).
+
+// m = 2^k: let the 64-bit product wrap and mask off the high bits.
+struct Lcg_pow2_mod {
+  uint64_t m, mask;
+
+  explicit Lcg_pow2_mod(uint64_t m) : m(m), mask(m - 1) {}
+
+  uint64_t modulus() const { return m; }
+  uint64_t mul_add(uint64_t a, uint64_t x, uint64_t c) const {
+    return (a * x + c) & mask;
+  }
+};
+
+// m <= 2^32: (m - 1)^2 + (m - 1) < 2^64, one 64-bit product is enough.
+struct Lcg_mod32 {
+  uint64_t m;
+
+  explicit Lcg_mod32(uint64_t m) : m(m) {}
+
+  uint64_t modulus() const { return m; }
+  uint64_t mul_add(uint64_t a, uint64_t x, uint64_t c) const {
+    return (a * x + c) % m;
+  }
+};
+
+// 2^32 < m < 2^64, typically a large prime: widen the product to 128 bits.
+struct Lcg_mod64 {
+  uint64_t m;
+
+  explicit Lcg_mod64(uint64_t m) : m(m) {}
+
+  uint64_t modulus() const { return m; }
+  uint64_t mul_add(uint64_t a, uint64_t x, uint64_t c) const {
+    return (uint64_t)(((unsigned __int128)a * x + c) % m);
+  }
+};
+
+// Modulus known at compile time. Picks the same path as the runtime
+// policies, but lets the compiler turn the reduction into a multiply/shift.
+template <uint64_t M> struct Lcg_fixed_mod {
+  static_assert(M > 0, "lcg: modulus must be positive");
+
+  uint64_t modulus() const { return M; }
+  uint64_t mul_add(uint64_t a, uint64_t x, uint64_t c) const {
+    return reduce(a, x, c, Path());
+  }
+
+private:
+  typedef std::integral_constant<int, (M & (M - 1)) == 0    ? 0
+                                      : M <= (1ULL << 32) ? 1
+                                                          : 2>
+      Path;
+
+  static uint64_t reduce(uint64_t a, uint64_t x, uint64_t c,
+                         std::integral_constant<int, 0>) {
+    return (a * x + c) & (M - 1);
+  }
+  static uint64_t reduce(uint64_t a, uint64_t x, uint64_t c,
+                         std::integral_constant<int, 1>) {
+    return (a * x + c) % M;
+  }
+  static uint64_t reduce(uint64_t a, uint64_t x, uint64_t c,
+                         std::integral_constant<int, 2>) {
+    return (uint64_t)(((unsigned __int128)a * x + c) % M);
+  }
+};
+
+// Block-filling engine. fill() runs `lanes` copies of the recurrence side by
+// side, lane j holding x_{k+j}, and advances every lane by `lanes` steps at a
+// time with the jump-ahead constants (A^L, C_L). The lanes are independent,
+// so the loop has no serial dependency and the compiler can keep them in
+// vector registers; the output is still the plain scalar sequence.
+template <class Mod> class Lcg_engine {
+public:
+  static const std::size_t lanes = 8;
+
+  Lcg_engine(Mod mod, uint64_t a, uint64_t c, uint64_t seed)
+      : mod(mod), a(a % mod.modulus()), c(c % mod.modulus()),
+        x(seed % mod.modulus()),
+        scale(1.0 / (1.0 + (double)(mod.modulus() - 1))) {
+    power(lanes, jump_a, jump_c);
+  }
+
+  // The last value produced; the next value is (a * state + c) mod m.
+  uint64_t state() const { return x; }
+
+  uint64_t next() { return x = mod.mul_add(a, x, c); }
+
+  // Skip k values in O(log k).
+  void discard(uint64_t k) {
+    uint64_t ak, ck;
+    power(k, ak, ck);
+    x = mod.mul_add(ak, x, ck);
+  }
+
+  // out[i] = x_{i+1} / m, the same doubles the old scalar loop produced.
+  void fill(double *out, std::size_t n) { generate(out, n, To_uniform(scale)); }
+
+  void fill_raw(uint64_t *out, std::size_t n) { generate(out, n, To_raw()); }
+
+private:
+  struct To_uniform {
+    double scale;
+    explicit To_uniform(double scale) : scale(scale) {}
+    double operator()(uint64_t v) const { return (double)v * scale; }
+  };
+
+  struct To_raw {
+    uint64_t operator()(uint64_t v) const { return v; }
+  };
+
+  // (ak, ck) such that x_{n+k} = (ak * x_n + ck) mod m.
+  void power(uint64_t k, uint64_t &ak, uint64_t &ck) const {
+    uint64_t base_a = a, base_c = c;
+    ak = 1 % mod.modulus();
+    ck = 0;
+    while (k > 0) {
+      if (k & 1) {
+        ck = mod.mul_add(base_a, ck, base_c);
+        ak = mod.mul_add(base_a, ak, 0);
+      }
+      base_c = mod.mul_add(base_a, base_c, base_c);
+      base_a = mod.mul_add(base_a, base_a, 0);
+      k >>= 1;
+    }
+  }
+
+  template <class T, class Convert>
+  void generate(T *out, std::size_t n, Convert convert) {
+    if (n < lanes) {
+      for (std::size_t i = 0; i < n; i++)
+        out[i] = convert(next());
+      return;
+    }
+
+    uint64_t lane[lanes];
+    lane[0] = mod.mul_add(a, x, c);
+    for (std::size_t j = 1; j < lanes; j++)
+      lane[j] = mod.mul_add(a, lane[j - 1], c);
+
+    std::size_t i = 0;
+    for (; i + lanes <= n; i += lanes) {
+      x = lane[lanes - 1];
+      for (std::size_t j = 0; j < lanes; j++)
+        out[i + j] = convert(lane[j]);
+      for (std::size_t j = 0; j < lanes; j++)
+        lane[j] = mod.mul_add(jump_a, lane[j], jump_c);
+    }
+
+    for (std::size_t j = 0; i + j < n; j++) {
+      out[i + j] = convert(lane[j]);
+      x = lane[j];
+    }
+  }
+
+  Mod mod;
+  uint64_t a, c, x;
+  uint64_t jump_a, jump_c;
+  double scale;
+};
+
+template <class Mod> const std::size_t Lcg_engine<Mod>::lanes;
+
+// Engine with all three parameters fixed at compile time.
+template <uint64_t A, uint64_t C, uint64_t M>
+class Lcg_fixed : public Lcg_engine<Lcg_fixed_mod<M> > {
+public:
+  static_assert(A < M && C < M, "lcg: a and c must be reduced mod m");
+
+  explicit Lcg_fixed(uint64_t seed)
+      : Lcg_engine<Lcg_fixed_mod<M> >(Lcg_fixed_mod<M>(), A, C, seed) {}
+};
+
+// Runtime front end for the -a/-c/-m/-seed flags. Keeps only the parameters
+// and the current state, and picks the fastest engine once per fill() call,
+// so callers can draw a long sequence in chunks.
+class Lcg_generator {
+public:
+  // Negative a, c and seed are reduced into [0, m) first. That is what the
+  // old int arithmetic computed whenever a * seed + c fit in an int; past
+  // that point the old code overflowed and this is the true recurrence.
+  Lcg_generator(int64_t a, int64_t c, int64_t m, int64_t seed)
+      : a(reduce(a, m)), c(reduce(c, m)), m(m), x(reduce(seed, m)) {}
+
+  uint64_t modulus() const { return m; }
+
+  void fill(double *out, std::size_t n) {
+    if (a == 13 && c == 1 && m == 100)
+      run(Lcg_fixed<13, 1, 100>(x), out, n);
+    else if ((m & (m - 1)) == 0)
+      run(Lcg_engine<Lcg_pow2_mod>(Lcg_pow2_mod(m), a, c, x), out, n);
+    else if (m <= (1ULL << 32))
+      run(Lcg_engine<Lcg_mod32>(Lcg_mod32(m), a, c, x), out, n);
+    else
+      run(Lcg_engine<Lcg_mod64>(Lcg_mod64(m), a, c, x), out, n);
+  }
+
+  void discard(uint64_t k) {
+    Lcg_engine<Lcg_mod64> engine(Lcg_mod64(m), a, c, x);
+    engine.discard(k);
+    x = engine.state();
+  }
+
+private:
+  static uint64_t reduce(int64_t v, int64_t m) {
+    int64_t r = v % m;
+    return (uint64_t)(r < 0 ? r + m : r);
+  }
+
+  template <class Engine> void run(Engine engine, double *out, std::size_t n) {
+    engine.fill(out, n);
+    x = engine.state();
+  }
+
+  uint64_t a, c, m, x;
+};
+
+#endif /* LCG_H */
@@ -0,0 +1,201 @@
+#ifndef OVERFLOW_ESTIMATOR_H
+#define OVERFLOW_ESTIMATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "batch-means.h"
+#include "exponential-traffic-source.h"
+
+namespace ns3 {
+
+// Estimates how likely a queue disc is to overflow, and the fraction of
+// packets it drops, by importance sampling: the sources send faster than
+// they should, so the rare overflow happens often, and every observation is
+// weighted by the likelihood ratio of the traffic that produced it.
+//
+// The run is cut into cycles that end whenever the queue disc and the
+// device queue behind it are both empty. Each cycle starts with every
+// source's rate scaled by twist (see ExponentialTrafficSource::
+// SetRateScale()); once the queue disc holds level packets the cycle has
+// overflowed and the sources go back to their own rates until it ends. The
+// cycle's weight L is the product of the sources' likelihood ratios over
+// the cycle, so with n cycles
+//
+//   P(overflow in a cycle) = mean of L * [overflowed]
+//   drop probability       = sum L * drops / sum L * arrivals
+//
+// each with a 95% interval, the second by the delta method for ratios of
+// regenerative sums. Both are unbiased for the untwisted system as far as
+// the cycles are independent. They are not quite: packets in flight
+// elsewhere in the network and the sources' pending gaps carry over, which
+// matters little when the queue empties often. A twist of 1 is plain
+// simulation with the same estimators.
+//
+// Only the gaps are twisted, not the sizes. The twist to use is about
+// 1 / utilisation of the queue, which takes its load to 1: on an M/M/1/20
+// queue at load 0.5 it puts the 1e-6 chance of a cycle filling the queue
+// within about 30% from 2e5 cycles, which plain simulation would not see
+// once in. Much more and the weights spread so far that the estimates come
+// out low with intervals too narrow to show it. Everything else measured
+// in the same run describes the twisted system.
+class OverflowEstimator {
+public:
+  OverflowEstimator(Ptr<QueueDisc> qdisc, Ptr<NetDevice> device,
+                    std::vector<Ptr<ExponentialTrafficSource>> sources,
+                    double twist, uint32_t level)
+      : m_qdisc(qdisc), m_sources(sources), m_twist(twist), m_level(level),
+        m_inCycle(false), m_overflowed(false), m_qdiscPackets(0),
+        m_devicePackets(0), m_logStart(0), m_drops(0), m_arrivals(0),
+        m_cycles(0), m_hits(0), m_y(0), m_yy(0), m_d(0), m_a(0), m_dd(0),
+        m_da(0), m_aa(0) {
+    NS_ABORT_MSG_IF(!(twist > 0), "OverflowEstimator: twist must be > 0");
+    NS_ABORT_MSG_IF(level == 0, "OverflowEstimator: level must be > 0");
+    PointerValue queue;
+    device->GetAttribute("TxQueue", queue);
+    m_deviceQueue = queue.Get<QueueBase>();
+    NS_ABORT_MSG_IF(!m_deviceQueue, "OverflowEstimator: device has no queue");
+  }
+
+  // Cycles start from the first time both queues are empty after start.
+  void Start(Time start) {
+    Simulator::Schedule(start - Simulator::Now(), &OverflowEstimator::Begin,
+                        this);
+  }
+
+  // Complete cycles, and those that overflowed.
+  uint64_t GetCycles() const { return m_cycles; }
+  uint64_t GetOverflows() const { return m_hits; }
+
+  double GetOverflowProbability() const {
+    return m_cycles ? m_y / m_cycles : NAN;
+  }
+
+  double GetOverflowHalfWidth() const {
+    if (m_cycles < 2)
+      return NAN;
+    double n = m_cycles, mean = m_y / n;
+    double variance = std::max(m_yy - n * mean * mean, 0.0) / (n - 1);
+    return StudentT975(m_cycles - 1) * std::sqrt(variance / n);
+  }
+
+  double GetDropProbability() const { return m_a > 0 ? m_d / m_a : NAN; }
+
+  double GetDropHalfWidth() const {
+    if (m_cycles < 2 || !(m_a > 0))
+      return NAN;
+    // sum (D - r A)^2 over the cycles, D and A weighted.
+    double n = m_cycles, r = m_d / m_a;
+    double ss = m_dd - 2 * r * m_da + r * r * m_aa;
+    double variance = std::max(ss, 0.0) / (n - 1);
+    return StudentT975(m_cycles - 1) * std::sqrt(variance / n) / (m_a / n);
+  }
+
+private:
+  void Begin() {
+    m_qdisc->TraceConnectWithoutContext(
+        "PacketsInQueue",
+        MakeCallback(&OverflowEstimator::QueueDiscChanged, this));
+    m_qdisc->TraceConnectWithoutContext(
+        "Enqueue", MakeCallback(&OverflowEstimator::Enqueued, this));
+    m_qdisc->TraceConnectWithoutContext(
+        "Drop", MakeCallback(&OverflowEstimator::Dropped, this));
+    m_deviceQueue->TraceConnectWithoutContext(
+        "PacketsInQueue",
+        MakeCallback(&OverflowEstimator::DeviceQueueChanged, this));
+    m_qdiscPackets = m_qdisc->GetNPackets();
+    m_devicePackets = m_deviceQueue->GetNPackets();
+    if (m_qdiscPackets == 0 && m_devicePackets == 0)
+      NextCycle();
+  }
+
+  void QueueDiscChanged(uint32_t oldValue, uint32_t newValue) {
+    m_qdiscPackets = newValue;
+    if (m_inCycle && !m_overflowed && newValue >= m_level) {
+      m_overflowed = true;
+      m_hits++;
+      SetRateScale(1);
+    }
+    IfEmpty();
+  }
+
+  void DeviceQueueChanged(uint32_t oldValue, uint32_t newValue) {
+    m_devicePackets = newValue;
+    IfEmpty();
+  }
+
+  void Enqueued(Ptr<const QueueDiscItem> item) { m_arrivals++; }
+
+  void Dropped(Ptr<const QueueDiscItem> item) {
+    m_drops++;
+    m_arrivals++;
+  }
+
+  void IfEmpty() {
+    if (m_qdiscPackets == 0 && m_devicePackets == 0)
+      NextCycle();
+  }
+
+  // Closes the cycle in progress, if any, and opens the next.
+  void NextCycle() {
+    double logRatio = LogLikelihoodRatio();
+    if (m_inCycle) {
+      double weight = std::exp(logRatio - m_logStart);
+      double y = m_overflowed ? weight : 0;
+      double d = weight * m_drops, a = weight * m_arrivals;
+      m_cycles++;
+      m_y += y;
+      m_yy += y * y;
+      m_d += d;
+      m_a += a;
+      m_dd += d * d;
+      m_da += d * a;
+      m_aa += a * a;
+    }
+    m_inCycle = true;
+    m_overflowed = false;
+    m_logStart = logRatio;
+    m_drops = m_arrivals = 0;
+    SetRateScale(m_twist);
+  }
+
+  double LogLikelihoodRatio() const {
+    double sum = 0;
+    for (Ptr<ExponentialTrafficSource> source : m_sources)
+      sum += source->GetLogLikelihoodRatio();
+    return sum;
+  }
+
+  void SetRateScale(double scale) {
+    for (Ptr<ExponentialTrafficSource> source : m_sources)
+      source->SetRateScale(scale);
+  }
+
+  Ptr<QueueDisc> m_qdisc;
+  Ptr<QueueBase> m_deviceQueue;
+  std::vector<Ptr<ExponentialTrafficSource>> m_sources;
+  double m_twist;
+  uint32_t m_level;
+
+  bool m_inCycle;
+  bool m_overflowed;
+  uint32_t m_qdiscPackets, m_devicePackets;
+  double m_logStart;
+  uint64_t m_drops, m_arrivals;
+
+  // Over the complete cycles: sums of Y = L * [overflowed], D = L * drops
+  // and A = L * arrivals, and of their squares and products.
+  uint64_t m_cycles, m_hits;
+  double m_y, m_yy;
+  double m_d, m_a, m_dd, m_da, m_aa;
+};
+
+} // namespace ns3
+
+#endif /* OVERFLOW_ESTIMATOR_H */
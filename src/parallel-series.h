@@ -0,0 +1,168 @@
+#ifndef PARALLEL_SERIES_H
+#define PARALLEL_SERIES_H
+
+#include "ns3/core-module.h"
+#include "ns3/rng-stream.h"
+
+#include "alias-sampler.h"
+#include "bulk-rng.h"
+#include "inverse-transform.h"
+#include "lcg.h"
+#include "part1-generators.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Multi-threaded generation of one part1 series.
+//
+// The series is cut into fixed blocks of block_size values, and what ends up
+// in block b depends only on the parameters and b, never on which thread
+// produced it:
+//
+//  - lcg/poi: block b starts from the seed jumped ahead b * block_size steps,
+//    so the output is the sequential sequence itself.
+//  - ns3/rvn/pdf: block b draws from its own MRG32k3a substream,
+//    RngStream(seed, stream, (RngRun << 32) + b), where stream is 0 for ns3,
+//    1 for rvn and 2 for pdf. This differs from the single-threaded sequence
+//    (which uses one automatically assigned stream) but is the same for any
+//    thread count, and RngRun still selects independent replications.
+//
+// Each fill() hands out up to window() values, workers * blocks_per_worker
+// blocks; worker t takes blocks t, t + workers, ... of the window. Memory is
+// bounded by the window, not by n.
+class Parallel_series {
+public:
+  static const int block_size = 1 << 16;
+  static const int blocks_per_worker = 4;
+
+  Parallel_series(const std::string &name, const Series_params &p,
+                  int threads)
+      : name(name), p(p), next_block(0), workers(std::max(threads, 1)),
+        generation(0), pending(0), stopping(false) {
+    NS_ABORT_MSG_IF(p.m <= 0, "lcg: modulus must be positive, got " << p.m);
+    NS_ABORT_MSG_IF(name != "lcg" && name != "poi" && name != "ns3" &&
+                        name != "rvn" && name != "pdf",
+                    "no parallel generator for series " << name);
+
+    if (name == "pdf")
+      table.reset(new Alias_sampler(pdf_sampler(p.pmf)));
+
+    for (int t = 1; t < workers; t++)
+      pool.push_back(std::thread(&Parallel_series::worker_loop, this, t));
+  }
+
+  ~Parallel_series() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread &t : pool)
+      t.join();
+  }
+
+  int window() const { return workers * blocks_per_worker * block_size; }
+
+  // Fills the next k values. k must be a multiple of block_size except for
+  // the last call of a series.
+  void fill(double *out, int k) {
+    int blocks = (k + block_size - 1) / block_size;
+
+    // ns-3 objects are not thread-safe, so the substreams are set up here.
+    streams.clear();
+    if (name == "ns3" || name == "rvn" || name == "pdf") {
+      uint64_t stream = name == "ns3" ? 0 : name == "rvn" ? 1 : 2;
+      for (int b = 0; b < blocks; b++)
+        streams.push_back(ns3::RngStream(
+            ns3::RngSeedManager::GetSeed(), stream,
+            (ns3::RngSeedManager::GetRun() << 32) + next_block + b));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job_out = out;
+      job_values = k;
+      job_blocks = blocks;
+      pending = workers - 1;
+      generation++;
+    }
+    wake.notify_all();
+
+    run_blocks(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]() { return pending == 0; });
+    next_block += blocks;
+  }
+
+private:
+  void worker_loop(int t) {
+    uint64_t seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]() { return stopping || generation != seen; });
+        if (stopping)
+          return;
+        seen = generation;
+      }
+
+      run_blocks(t);
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--pending == 0)
+        done.notify_one();
+    }
+  }
+
+  void run_blocks(int t) {
+    for (int b = t; b < job_blocks; b += workers) {
+      int start = b * block_size;
+      int k = std::min(block_size, job_values - start);
+      fill_block(b, job_out + start, k);
+    }
+  }
+
+  // Block b of the current window, i.e. block next_block + b of the series.
+  void fill_block(int b, double *out, int k) {
+    if (name == "lcg" || name == "poi") {
+      Lcg_generator gen(p.a, p.c, p.m, p.seed);
+      gen.discard((uint64_t)(next_block + b) * block_size);
+      gen.fill(out, k);
+      if (name == "poi")
+        exponential_inplace(out, k, p.lambda, p.exact_log);
+    } else if (name == "ns3") {
+      bulk_uniform(&streams[b], p.min, p.max, false, out, k);
+    } else if (name == "rvn") {
+      bulk_exponential(&streams[b], p.lambda, p.bound, false, out, k);
+    } else {
+      table->sample(&streams[b], out, k);
+    }
+  }
+
+  std::string name;
+  Series_params p;
+  uint64_t next_block;
+  std::vector<ns3::RngStream> streams;
+  std::unique_ptr<Alias_sampler> table;
+
+  int workers;
+  std::vector<std::thread> pool;
+  std::mutex mutex;
+  std::condition_variable wake, done;
+  uint64_t generation;
+  int pending;
+  bool stopping;
+
+  double *job_out;
+  int job_values, job_blocks;
+};
+
+#endif /* PARALLEL_SERIES_H */
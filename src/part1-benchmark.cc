@@ -0,0 +1,192 @@
+#include "ns3/core-module.h"
+
+#include "alloc-counter-impl.h"
+#include "file-writer.h"
+#include "part1-generators.h"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// Microbenchmarks for the part1 generators and File_writer.
+//
+// For every generator and every n it reports ns/sample, samples/s and the
+// heap traffic per sample, one CSV row each, so two builds can be compared
+// with a diff or a spreadsheet:
+//
+//   benchmark,mode,n,reps,ns_per_sample,samples_per_s,allocs_per_sample,
+//   alloc_bytes_per_sample
+//
+// mode "stream" is the chunked path project-part1 uses; mode "vector" is the
+// old vector-returning API, skipped above -maxVectorN to keep memory sane.
+// The file_writer rows time writing n values that are already generated;
+// they are skipped above -maxVectorN as well, since at n = 1e9 the files
+// would take about 10 GB of CSV and 8 GB of binary.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Part1Benchmark");
+
+struct Result {
+  std::string benchmark, mode;
+  int n;
+  int reps;
+  double seconds;
+  Alloc_snapshot allocs;
+};
+
+// Repeats run() until at least min_samples values have been produced, so
+// small n still get a measurable interval.
+template <class Run>
+Result measure(std::string benchmark, std::string mode, int n,
+               double min_samples, Run run) {
+  Result r;
+  r.benchmark = benchmark;
+  r.mode = mode;
+  r.n = n;
+  r.reps = std::max(1, (int)(min_samples / n));
+
+  // Warm-up: first-touch page faults and lazy ns-3 setup. Large n amortise
+  // that themselves and would only double the run time.
+  if (r.reps > 1)
+    run();
+
+  Alloc_snapshot before = alloc_snapshot();
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < r.reps; i++)
+    run();
+  auto stop = std::chrono::steady_clock::now();
+  Alloc_snapshot after = alloc_snapshot();
+
+  r.seconds = std::chrono::duration<double>(stop - start).count();
+  r.allocs.calls = after.calls - before.calls;
+  r.allocs.bytes = after.bytes - before.bytes;
+  return r;
+}
+
+void report(std::ostream &out, const Result &r) {
+  double samples = (double)r.n * r.reps;
+  char line[256];
+  std::snprintf(line, sizeof(line), "%s,%s,%d,%d,%.3f,%.4g,%.4g,%.4g",
+                r.benchmark.c_str(), r.mode.c_str(), r.n, r.reps,
+                r.seconds * 1e9 / samples, samples / r.seconds,
+                r.allocs.calls / samples, r.allocs.bytes / samples);
+  out << line << std::endl;
+}
+
+std::vector<int> parse_sizes(std::string list) {
+  std::vector<int> sizes;
+  std::stringstream ss(list);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    double size = std::stod(item);
+    NS_ABORT_MSG_IF(!(size >= 0 && size <= INT_MAX),
+                    "part1-benchmark: size out of int range: " << item);
+    sizes.push_back((int)size);
+  }
+  return sizes;
+}
+
+int main(int argc, char *argv[]) {
+  Series_params p;
+  std::string sizes = "1e3,1e5,1e7,1e9";
+  std::string generators = "lcg,ns3,poi,rvn,pdf";
+  std::string output;
+  double minSamples = 1e7;
+  int maxVectorN = 10000000;
+
+  CommandLine cmd;
+  cmd.AddValue("sizes", "Comma separated list of n", sizes);
+  cmd.AddValue("generators", "Comma separated list of series", generators);
+  cmd.AddValue("minSamples", "Repeat small n until this many samples",
+               minSamples);
+  cmd.AddValue("maxVectorN", "Largest n for the vector API and File_writer",
+               maxVectorN);
+  cmd.AddValue("output", "Also write the CSV rows to this file", output);
+  cmd.AddValue("lambda", "", p.lambda);
+  cmd.AddValue("bound", "", p.bound);
+  cmd.AddValue("m", "", p.m);
+  cmd.AddValue("a", "", p.a);
+  cmd.AddValue("c", "", p.c);
+  cmd.AddValue("exact_log", "", p.exact_log);
+  cmd.Parse(argc, argv);
+
+  std::ofstream file;
+  if (!output.empty())
+    file.open(output);
+
+  std::vector<Result> results;
+  std::vector<int> ns = parse_sizes(sizes);
+  std::stringstream names(generators);
+  std::string name;
+
+  const int chunk_size = 1 << 16;
+  std::vector<double> chunk(chunk_size);
+
+  while (std::getline(names, name, ',')) {
+    for (int n : ns) {
+      std::function<void(double *, int)> fill = make_series(name, p);
+      results.push_back(measure(name, "stream", n, minSamples, [&]() {
+        for (int left = n, k; left > 0; left -= k)
+          fill(chunk.data(), k = std::min(chunk_size, left));
+      }));
+
+      if (n > maxVectorN)
+        continue;
+
+      results.push_back(measure(name, "vector", n, minSamples, [&]() {
+        std::vector<double> v;
+        if (name == "lcg")
+          v = lcg_rand(p.a, p.c, p.m, p.seed, n);
+        else if (name == "ns3")
+          v = ns3_urv(p.min, p.max, n);
+        else if (name == "poi") {
+          v = lcg_rand(p.a, p.c, p.m, p.seed, n);
+          poisson(v.data(), p.lambda, n, p.exact_log);
+        } else if (name == "rvn")
+          v = ns3_rvn(p.lambda, p.bound, n);
+        else
+          v = prob_func(n);
+      }));
+    }
+  }
+
+  // File_writer on its own: n values already in memory, written chunk by
+  // chunk in each format.
+  make_series("lcg", p)(chunk.data(), chunk_size);
+  const char *formats[] = {"csv", "bin"};
+  for (const char *format : formats) {
+    for (int n : ns) {
+      if (n > maxVectorN)
+        continue;
+      results.push_back(measure("file_writer", format, n, minSamples, [&]() {
+        File_writer fw;
+        fw.set_filename("part1-benchmark-output");
+        fw.set_format(std::string(format) == "csv" ? File_writer::CSV
+                                                   : File_writer::BINARY);
+        fw.begin_series("lcg");
+        for (int left = n, k; left > 0; left -= k)
+          fw.write_chunk(chunk.data(), k = std::min(chunk_size, left));
+        fw.end_series();
+        fw.write();
+      }));
+    }
+    std::remove(("part1-benchmark-output." + std::string(format)).c_str());
+  }
+
+  const char *header = "benchmark,mode,n,reps,ns_per_sample,samples_per_s,"
+                       "allocs_per_sample,alloc_bytes_per_sample";
+  std::cout << header << std::endl;
+  if (file.is_open())
+    file << header << std::endl;
+  for (const Result &r : results) {
+    report(std::cout, r);
+    if (file.is_open())
+      report(file, r);
+  }
+
+  return 0;
+}
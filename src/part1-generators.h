@@ -0,0 +1,191 @@
+#ifndef PART1_GENERATORS_H
+#define PART1_GENERATORS_H
+
+#include "ns3/core-module.h"
+
+#include "alias-sampler.h"
+#include "bulk-rng.h"
+#include "file-writer.h"
+#include "goodness-of-fit.h"
+#include "inverse-transform.h"
+#include "lcg.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The part1 random number generators, shared by project-part1.cc and
+// part1-benchmark.cc.
+
+inline Lcg_generator lcg_create(long a, int c, int m, int seed) {
+  NS_ABORT_MSG_IF(m <= 0, "lcg: modulus must be positive, got " << m);
+
+  return Lcg_generator(a, c, m, seed);
+}
+
+inline std::vector<double> lcg_rand(long a, int c, int m, int seed, int n) {
+  std::vector<double> values(std::max(n, 0));
+  lcg_create(a, c, m, seed).fill(values.data(), values.size());
+
+  return values;
+}
+
+// Turns the uniforms in U into exponential inter-arrival times in place.
+inline void poisson(double *U, double lambda, int length,
+                    bool exact_log = false) {
+  exponential_inplace(U, std::max(length, 0), lambda, exact_log);
+}
+
+inline ns3::Ptr<ns3::UniformRandomVariable> ns3_urv_create(double min,
+                                                           double max) {
+  ns3::Ptr<ns3::UniformRandomVariable> x =
+      ns3::CreateObject<ns3::UniformRandomVariable>();
+  x->SetAttribute("Min", ns3::DoubleValue(min));
+  x->SetAttribute("Max", ns3::DoubleValue(max));
+
+  return x;
+}
+
+inline void ns3_urv(ns3::Ptr<ns3::UniformRandomVariable> x, double *out,
+                    int n) {
+  bulk_uniform(x, out, std::max(n, 0));
+}
+
+inline std::vector<double> ns3_urv(double min, double max, int n) {
+  std::vector<double> data(std::max(n, 0));
+  ns3_urv(ns3_urv_create(min, max), data.data(), n);
+
+  return data;
+}
+
+inline ns3::Ptr<ns3::ExponentialRandomVariable> ns3_rvn_create(double mean,
+                                                               double bound) {
+  ns3::Ptr<ns3::ExponentialRandomVariable> x =
+      ns3::CreateObject<ns3::ExponentialRandomVariable>();
+  x->SetAttribute("Mean", ns3::DoubleValue(mean));
+  x->SetAttribute("Bound", ns3::DoubleValue(bound));
+
+  return x;
+}
+
+inline void ns3_rvn(ns3::Ptr<ns3::ExponentialRandomVariable> x, double *out,
+                    int n) {
+  bulk_exponential(x, out, std::max(n, 0));
+}
+
+inline std::vector<double> ns3_rvn(double mean, double bound, int n) {
+  std::vector<double> data(std::max(n, 0));
+  ns3_rvn(ns3_rvn_create(mean, bound), data.data(), n);
+
+  return data;
+}
+
+// The distribution -pdf draws from: the PMF or histogram in file, or if file
+// is empty the one prob_func() has always produced, 200 equally likely
+// values k * 0.1 / 360.
+inline Alias_sampler pdf_sampler(const std::string &file) {
+  if (!file.empty())
+    return Alias_sampler::from_file(file);
+
+  std::vector<double> values, weights;
+  for (int k = 0; k < 200; k++) {
+    values.push_back(k * 0.1 / 360);
+    weights.push_back(1);
+  }
+  return Alias_sampler(values, weights);
+}
+
+inline void prob_func(const Alias_sampler &table,
+                      ns3::Ptr<ns3::RandomVariableStream> x, double *out,
+                      int n) {
+  table.sample(x, out, std::max(n, 0));
+}
+
+inline std::vector<double> prob_func(int n) {
+  std::vector<double> data(std::max(n, 0));
+  prob_func(pdf_sampler(""), ns3::CreateObject<ns3::UniformRandomVariable>(),
+            data.data(), n);
+
+  return data;
+}
+
+// Produces one series of n values through fw, chunk by chunk, so memory is
+// bounded by the chunk size whatever -n is.
+inline void stream_series(File_writer &fw, std::string name, int n,
+                          std::function<void(double *, int)> fill,
+                          int chunk_size = 1 << 16) {
+  std::vector<double> chunk(std::min(std::max(n, 0), chunk_size));
+
+  fw.begin_series(name);
+  for (int left = n, k; left > 0; left -= k) {
+    k = std::min(chunk_size, left);
+    fill(chunk.data(), k);
+    fw.write_chunk(chunk.data(), k);
+  }
+  fw.end_series();
+}
+
+// Everything a series needs from the command line.
+struct Series_params {
+  double min = 0.0, max = 1.0, lambda = 3.14, bound = 1.0;
+  int a = 13, c = 1, m = 100, seed = 1;
+  bool exact_log = false;
+  std::string pmf;
+};
+
+// Chunk filler for the series called name ("lcg", "ns3", "poi", "rvn" or
+// "pdf"). Each call continues where the previous one stopped.
+inline std::function<void(double *, int)>
+make_series(const std::string &name, const Series_params &p) {
+  if (name == "lcg") {
+    Lcg_generator gen = lcg_create(p.a, p.c, p.m, p.seed);
+    return [=](double *out, int k) mutable { gen.fill(out, k); };
+  }
+
+  if (name == "ns3") {
+    ns3::Ptr<ns3::UniformRandomVariable> x = ns3_urv_create(p.min, p.max);
+    return [=](double *out, int k) { ns3_urv(x, out, k); };
+  }
+
+  if (name == "poi") {
+    Lcg_generator gen = lcg_create(p.a, p.c, p.m, p.seed);
+    double lambda = p.lambda;
+    bool exact_log = p.exact_log;
+    return [=](double *out, int k) mutable {
+      gen.fill(out, k);
+      poisson(out, lambda, k, exact_log);
+    };
+  }
+
+  if (name == "rvn") {
+    ns3::Ptr<ns3::ExponentialRandomVariable> x =
+        ns3_rvn_create(p.lambda, p.bound);
+    return [=](double *out, int k) { ns3_rvn(x, out, k); };
+  }
+
+  NS_ABORT_MSG_IF(name != "pdf", "unknown series " << name);
+  std::shared_ptr<Alias_sampler> table =
+      std::make_shared<Alias_sampler>(pdf_sampler(p.pmf));
+  ns3::Ptr<ns3::UniformRandomVariable> x =
+      ns3::CreateObject<ns3::UniformRandomVariable>();
+  return [=](double *out, int k) { prob_func(*table, x, out, k); };
+}
+
+// Distribution a series is supposed to follow, for Gof_stream.
+inline Gof_target series_target(const std::string &name,
+                                const Series_params &p) {
+  if (name == "ns3")
+    return Gof_target::uniform(p.min, p.max);
+  if (name == "poi")
+    return Gof_target::exponential(1 / p.lambda);
+  if (name == "rvn")
+    return Gof_target::exponential(p.lambda, p.bound);
+
+  NS_ABORT_MSG_IF(name != "lcg", "no target distribution for series " << name);
+  return Gof_target::uniform(0, 1);
+}
+
+#endif /* PART1_GENERATORS_H */
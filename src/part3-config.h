@@ -0,0 +1,159 @@
+#ifndef PART3_CONFIG_H
+#define PART3_CONFIG_H
+
+#include <cstdint>
+#include <string>
+
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// Everything project-part3-p2p and project-part3-csma can be told on the
+// command line. The two programs differ only in the link type and in the
+// defaults the constructor picks for it.
+//
+// The flags beyond the original program's, and where each is described:
+//
+//   --distributed        MPI ranks, RunPart3() and part3-topology.h
+//   --scheduler          the event set, SchedulerTypeName()
+//   --benchmark          simulator performance, counting-scheduler.h
+//   --profile            per-handler event costs, profiling-scheduler.h
+//   --flowStatsInterval  periodic flow counters, flow-stats-exporter.h
+//   --stopPrecision      stop once accurate, sequential-stop.h
+//   --overflowTwist      rare G-S overflows, overflow-estimator.h
+//   --capture            sampled pcap of single devices, sampled-pcap.h
+//   --antithetic         1 - U everywhere, the streams in RunPart3()
+//   --analytic           the queueing model instead of a run, part3-model.h
+struct Part3Config {
+  Part3Config(std::string linkType)
+      : link(linkType), simulationTime(linkType == "p2p" ? 10 : 11),
+        queueSize("1000"), stopPrecision(0), stopInterval(0.05),
+        queueSampleInterval(0), queueTrace(true), monitorAllQueues(false),
+        binaryQueueTrace(false), enableFlowMonitor(true),
+        flowStatsInterval(0), distributed(false),
+        enableTraces(linkType == "p2p"), captureSampling(1),
+        captureSnapLen(64), captureStart(0), captureStop(0),
+        scheduler("map"), benchmark(false),
+        profileFolded(false), antithetic(false), overflowTwist(0),
+        overflowLevel(0), analytic(false),
+        nSources(4), nRouters(2), meanA(0.002), meanB(0.002), meanC(0.0005),
+        meanD(0.001), meanSize(linkType == "p2p" ? 200 : 150),
+        accessRate("5Mbps"), coreRate("8Mbps"), serverRate("10Mbps") {}
+
+  void AddValues(CommandLine &cmd) {
+    cmd.AddValue("simulationTime", "Simulation time in seconds",
+                 simulationTime);
+    cmd.AddValue("queueSize", "Queue disc size on G-S in packets", queueSize);
+    cmd.AddValue("stopPrecision",
+                 "Stop once the G-S estimates are this precise, relative to "
+                 "their means; 0 runs the full simulationTime",
+                 stopPrecision);
+    cmd.AddValue("stopInterval",
+                 "Seconds per observation for --stopPrecision", stopInterval);
+    cmd.AddValue("queueSampleInterval",
+                 "Sample queues every this many seconds, 0 on change",
+                 queueSampleInterval);
+    cmd.AddValue("queueTrace", "Write queue occupancy and histogram files",
+                 queueTrace);
+    cmd.AddValue("monitorAllQueues", "Record every queue", monitorAllQueues);
+    cmd.AddValue("binaryQueueTrace", "Binary queue traces", binaryQueueTrace);
+    cmd.AddValue("EnableMonitor", "Enable Flow Monitor", enableFlowMonitor);
+    cmd.AddValue("flowStatsInterval",
+                 "Export flow statistics every this many seconds, 0 for the "
+                 "XML dump at the end",
+                 flowStatsInterval);
+    cmd.AddValue("distributed", "Run on all MPI ranks", distributed);
+    cmd.AddValue("enableTraces", "Ascii and pcap device traces",
+                 enableTraces);
+    cmd.AddValue("capture", "Devices to capture sampled pcap of, e.g. gs,sg",
+                 capture);
+    cmd.AddValue("captureSampling", "Fraction of the packets captured",
+                 captureSampling);
+    cmd.AddValue("captureSnapLen", "Bytes captured per packet",
+                 captureSnapLen);
+    cmd.AddValue("captureStart", "Start of the capture in seconds",
+                 captureStart);
+    cmd.AddValue("captureStop", "End of the capture in seconds, 0 for none",
+                 captureStop);
+    cmd.AddValue("scheduler", "Event scheduler: map, heap, list, calendar, "
+                 "priorityqueue or a TypeId name", scheduler);
+    cmd.AddValue("benchmark", "Report simulator performance", benchmark);
+    cmd.AddValue("profile", "Write an event profile with this prefix",
+                 profile);
+    cmd.AddValue("profileFolded", "Add a flame graph profile",
+                 profileFolded);
+    cmd.AddValue("antithetic", "Drive the run with 1 - U", antithetic);
+    cmd.AddValue("overflowTwist",
+                 "Estimate the G-S overflow probability with the source "
+                 "rates scaled by this, 0 not at all",
+                 overflowTwist);
+    cmd.AddValue("overflowLevel",
+                 "Packets in G-S's queue disc that count as an overflow, 0 "
+                 "for queueSize",
+                 overflowLevel);
+    cmd.AddValue("analytic", "Evaluate the queueing model, do not simulate",
+                 analytic);
+    cmd.AddValue("nSources", "Number of sources", nSources);
+    cmd.AddValue("nRouters", "Number of aggregation routers", nRouters);
+    cmd.AddValue("meanA", "Mean gap of sources 0, 4, 8, ... in seconds",
+                 meanA);
+    cmd.AddValue("meanB", "Mean gap of sources 1, 5, 9, ... in seconds",
+                 meanB);
+    cmd.AddValue("meanC", "Mean gap of sources 2, 6, 10, ... in seconds",
+                 meanC);
+    cmd.AddValue("meanD", "Mean gap of sources 3, 7, 11, ... in seconds",
+                 meanD);
+    cmd.AddValue("meanSize", "Mean packet size in bytes", meanSize);
+    cmd.AddValue("accessRate", "Rate of the source links", accessRate);
+    cmd.AddValue("coreRate", "Rate of the router uplinks and G-R", coreRate);
+    cmd.AddValue("serverRate", "Rate of G-S", serverRate);
+    cmd.AddValue("summary", "Write the run's results to this file", summary);
+  }
+
+  std::string link;           // "p2p" or "csma"
+  double simulationTime;      // seconds
+  std::string queueSize;      // packets
+  double stopPrecision;       // relative 95% half-width, 0 for a fixed time
+  double stopInterval;        // seconds
+  double queueSampleInterval; // seconds, 0 records every change instead
+  bool queueTrace;            // off keeps only the statistics
+  bool monitorAllQueues;      // every queue disc and device queue
+  bool binaryQueueTrace;      // .qtr files, see queue-trace-to-text.cc
+  bool enableFlowMonitor;
+  double flowStatsInterval;   // seconds, 0 dumps XML at the end instead
+  bool distributed;           // partition over the MPI ranks
+  bool enableTraces;          // ascii and pcap traces of every device
+  std::string capture;        // device labels, empty for no capture
+  double captureSampling;     // fraction of the packets
+  uint32_t captureSnapLen;    // bytes
+  double captureStart;        // seconds
+  double captureStop;         // seconds, 0 until the end
+  std::string scheduler;      // see SchedulerTypeName()
+  bool benchmark;             // performance figures in the summary
+  std::string profile;        // prefix, empty for no profile
+  bool profileFolded;
+  bool antithetic;            // the antithetic twin of the run
+  double overflowTwist;       // source rate scale, 0 for no estimate
+  uint32_t overflowLevel;     // packets, 0 for queueSize
+  bool analytic;              // the model of part3-model.h instead of a run
+
+  // 4 sources and 2 routers is the original A-E-G, B/C-F-G, D-G network,
+  // see part3-topology.h.
+  uint32_t nSources;
+  uint32_t nRouters;
+
+  // Mean inter-transmission times, cycling A, B, C, D over the sources,
+  // and the mean packet size
+  double meanA, meanB, meanC, meanD; // seconds
+  double meanSize;                   // bytes
+
+  std::string accessRate;
+  std::string coreRate;
+  std::string serverRate;
+
+  std::string summary; // "key value" results, see run-summary.h
+};
+
+} // namespace ns3
+
+#endif /* PART3_CONFIG_H */
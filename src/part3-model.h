@@ -0,0 +1,369 @@
+#ifndef PART3_MODEL_H
+#define PART3_MODEL_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include "part3-config.h"
+#include "part3-topology.h"
+#include "queue-model.h"
+#include "run-summary.h"
+
+namespace ns3 {
+
+// Queueing model of the part3 network: every transmit queue the simulation
+// would have is estimated with queue-model.h from the rates a Part3Config
+// implies, which takes microseconds instead of a run.
+//
+// The traffic is the simulation's. Source i sends 1 / mean packets per
+// second of max(12, Exp(meanSize)) bytes to S, which forwards
+// ForwardProbability of what it receives to R and bounces the rest back to
+// the source. R has no socket on the port and answers every forwarded
+// packet with an ICMP port unreachable, which shares G-S with the sources'
+// packets. Each flow is thinned by the loss of every queue it passes, so
+// the rates depend on the losses and, through R, G-S on itself; the
+// estimates are repeated until the losses settle.
+//
+// Arrivals past the first queue are taken as Poisson, Kleinrock's
+// independence approximation, which is good well below saturation. A CSMA
+// link is half duplex, so each side's wait and loss count the other side's
+// traffic too; collisions and backoff are left out.
+//
+// NeedsSimulation() says where the estimates should not be trusted:
+//  - a utilisation of MaxUtilisation (0.9) or more,
+//  - a loss of MaxLoss (0.001) or more, where the finite buffer shapes the
+//    result, e.g. once the 1000p FIFO on G-S starts to fill,
+//  - the default FqCoDel queue disc delaying packets past CoDel's 5 ms
+//    target MaxLoss of the time or more, as CoDel's drops are not modelled.
+class Part3Model {
+public:
+  Part3Model(const Part3Config &config)
+      : m_config(config), m_forwardProbability(0.7), m_maxUtilisation(0.9),
+        m_maxLoss(0.001) {
+    Build();
+    Evaluate();
+  }
+
+  // ServerReflector's ForwardProbability, 0.7 unless changed.
+  void SetForwardProbability(double p) {
+    m_forwardProbability = p;
+    Evaluate();
+  }
+
+  void SetLimits(double maxUtilisation, double maxLoss) {
+    m_maxUtilisation = maxUtilisation;
+    m_maxLoss = maxLoss;
+  }
+
+  // One per transmit queue, named <from>-<to> with G, S, R, router<r> and
+  // source<i> for the nodes.
+  const std::vector<QueueEstimate> &GetQueues() const { return m_estimates; }
+
+  // G's queue towards S, the one QueueMonitor records as "gs".
+  const QueueEstimate &GetServerQueue() const { return m_estimates[0]; }
+
+  // Mean end-to-end delay over every packet delivered, ICMP included, as
+  // FlowTally measures it.
+  double GetMeanDelay() const { return m_meanDelay; }
+  // Packets per second delivered, and lost on the way.
+  double GetDeliveredRate() const { return m_delivered; }
+  double GetLostRate() const { return m_lost; }
+  // Packets per second S forwards to R and bounces back.
+  double GetForwardedRate() const { return m_forwarded; }
+  double GetBouncedRate() const { return m_bounced; }
+
+  // Why the estimates should not be trusted, empty if they can be.
+  std::vector<std::string> NeedsSimulation() const {
+    std::vector<std::string> reasons;
+    char text[160];
+    for (std::size_t q = 0; q < m_queues.size(); q++) {
+      const QueueEstimate &e = m_estimates[q];
+      if (e.utilisation >= m_maxUtilisation) {
+        std::snprintf(text, sizeof(text), "%s is %.3g utilised",
+                      e.name.c_str(), e.utilisation);
+        reasons.push_back(text);
+      }
+      if (e.loss >= m_maxLoss) {
+        std::snprintf(text, sizeof(text), "%s drops %.3g of its packets",
+                      e.name.c_str(), e.loss);
+        reasons.push_back(text);
+      }
+      if (m_queues[q].fqCoDel) {
+        // Packets past the device queue that take CoDel's 5 ms target to
+        // drain.
+        const Queue &queue = m_queues[q];
+        double service = e.meanDelay - e.meanWait;
+        uint32_t room = queue.queueDisc + queue.deviceQueue + 1;
+        uint32_t held = queue.deviceQueue + 1 +
+                        (uint32_t)std::ceil(e.utilisation > 0
+                                                ? 0.005 / service
+                                                : 0);
+        double late = QueueTail(e.utilisation, room, held);
+        if (late >= m_maxLoss) {
+          std::snprintf(text, sizeof(text),
+                        "%s is past FqCoDel's target %.3g of the time",
+                        e.name.c_str(), late);
+          reasons.push_back(text);
+        }
+      }
+    }
+    return reasons;
+  }
+
+  void Print(std::FILE *out) const {
+    std::fprintf(out, "# queue arrival_rate utilisation mean_packets "
+                      "mean_delay loss queue_disc_packets "
+                      "queue_disc_delay\n");
+    for (const QueueEstimate &e : m_estimates) {
+      std::fprintf(out, "%s %.6g %.6g %.6g %.6g %.6g %.6g %.6g\n",
+                   e.name.c_str(), e.arrivalRate, e.utilisation,
+                   e.meanPackets, e.meanDelay, e.loss, e.queueDiscPackets,
+                   e.queueDiscDelay);
+    }
+    std::fprintf(out, "# end-to-end delay %.6g s, %.6g packets/s delivered, "
+                      "%.6g lost\n",
+                 m_meanDelay, m_delivered, m_lost);
+    std::vector<std::string> reasons = NeedsSimulation();
+    for (const std::string &reason : reasons)
+      std::fprintf(out, "# needs simulation: %s\n", reason.c_str());
+    if (reasons.empty())
+      std::fprintf(out, "# the model can stand in for the simulation\n");
+  }
+
+  // The predictions under the keys RunPart3 uses, for what the sources send
+  // from 2 s to the end of the run, and the model's verdict.
+  void Summarize(RunSummary &summary) const {
+    double active = std::max(m_config.simulationTime - 2, 0.0);
+    double maxUtilisation = 0, maxLoss = 0;
+    for (const QueueEstimate &e : m_estimates) {
+      maxUtilisation = std::max(maxUtilisation, e.utilisation);
+      maxLoss = std::max(maxLoss, e.loss);
+    }
+    summary.Set("queue_mean_packets", GetServerQueue().queueDiscPackets);
+    summary.Set("sojourn_mean", GetServerQueue().queueDiscDelay);
+    summary.Set("forwarded", m_forwarded * active);
+    summary.Set("bounced", m_bounced * active);
+    summary.Set("delay_mean", m_meanDelay);
+    summary.Set("rx_packets", m_delivered * active);
+    summary.Set("lost_packets", m_lost * active);
+    summary.Set("analytic_ok", NeedsSimulation().empty());
+    summary.Set("analytic_max_utilisation", maxUtilisation);
+    summary.Set("analytic_max_loss", maxLoss);
+  }
+
+private:
+  struct Queue {
+    std::string name;
+    double bitRate;
+    uint32_t deviceQueue, queueDisc;
+    bool fqCoDel; // the default queue disc rather than the FIFO
+    int peer;     // the other direction of the link
+  };
+
+  // A stream of one kind of packet along a path of queues.
+  struct Flow {
+    bool icmp;
+    std::vector<int> path;
+    double rate;      // packets per second sent
+    double delivered; // and arriving
+  };
+
+  // Both directions of a link, the first returned; queueDisc 0 for the
+  // default FqCoDel.
+  int AddLink(std::string a, std::string b, std::string rate,
+              uint32_t queueDisc) {
+    int first = m_queues.size();
+    uint32_t device = std::stoul(Part3Topology::DefaultDeviceQueue());
+    if (first == 0) // G-S
+      device = std::stoul(Part3Topology::DefaultServerDeviceQueue());
+    double bitRate = DataRate(rate).GetBitRate();
+    bool fqCoDel = queueDisc == 0;
+    if (fqCoDel)
+      queueDisc = 10240; // FqCoDel's default limit
+    Queue there = {a + "-" + b, bitRate, device, queueDisc, fqCoDel,
+                   first + 1};
+    Queue back = {b + "-" + a, bitRate, device, queueDisc, fqCoDel, first};
+    m_queues.push_back(there);
+    m_queues.push_back(back);
+    return first;
+  }
+
+  // The queues and flows of the topology Part3Topology builds.
+  void Build() {
+    uint32_t queueSize = std::stoul(m_config.queueSize);
+    int gs = AddLink("G", "S", m_config.serverRate, queueSize);
+    int gr = AddLink("G", "R", m_config.coreRate, 0);
+    int sg = gs + 1, rg = gr + 1;
+
+    uint32_t sources = m_config.nSources, routers = m_config.nRouters;
+    std::vector<int> attach = Part3Topology::Attachment(sources, routers);
+    bool classic = Part3Topology::IsClassic(sources, routers);
+    std::vector<int> uplinks(routers);
+    for (uint32_t r = 0; r < routers; r++) {
+      std::string rate =
+          classic && r == 0 ? m_config.accessRate : m_config.coreRate;
+      uplinks[r] = AddLink("router" + std::to_string(r), "G", rate, 0);
+    }
+
+    const double means[] = {m_config.meanA, m_config.meanB, m_config.meanC,
+                            m_config.meanD};
+    for (uint32_t i = 0; i < sources; i++) {
+      std::string to = attach[i] >= 0 ? "router" + std::to_string(attach[i])
+                                      : std::string("G");
+      int access =
+          AddLink("source" + std::to_string(i), to, m_config.accessRate, 0);
+      Flow up = {false, {access}, 1 / means[i % 4], 0};
+      Flow back = {false, {sg}, 0, 0};
+      if (attach[i] >= 0) {
+        up.path.push_back(uplinks[attach[i]]);
+        back.path.push_back(uplinks[attach[i]] + 1);
+      }
+      up.path.push_back(gs);
+      back.path.push_back(access + 1);
+      m_sources.push_back(m_flows.size());
+      m_flows.push_back(up);
+      m_bounces.push_back(m_flows.size());
+      m_flows.push_back(back);
+    }
+    Flow forward = {false, {sg, gr}, 0, 0};
+    m_forward = m_flows.size();
+    m_flows.push_back(forward);
+    Flow icmp = {true, {rg, gs}, 0, 0};
+    m_icmp = m_flows.size();
+    m_flows.push_back(icmp);
+
+    m_loss.assign(m_queues.size(), 0);
+  }
+
+  // Frame sizes as the devices send them: PPP or Ethernet with its FCS,
+  // padded to 64 bytes, around IPv4 and UDP or ICMP.
+  ServiceTime DataService(const Queue &queue) const {
+    bool p2p = m_config.link == "p2p";
+    return ServiceTime::Exponential(m_config.meanSize, 12,
+                                    (p2p ? 2 : 18) + 20 + 8, p2p ? 0 : 64,
+                                    queue.bitRate);
+  }
+
+  ServiceTime IcmpService(const Queue &queue) const {
+    // IPv4, ICMP and the unreachable message quoting the IPv4 header and
+    // 8 bytes of the packet.
+    bool p2p = m_config.link == "p2p";
+    double frame = (p2p ? 2 : 18) + 20 + 4 + 4 + 20 + 8;
+    return ServiceTime::Fixed(p2p ? frame : std::max(frame, 64.0),
+                              queue.bitRate);
+  }
+
+  // Sends every flow through the queues with the current losses, estimates
+  // the queues from what arrives, and repeats until the losses settle.
+  void Evaluate() {
+    double p = m_forwardProbability;
+    for (int pass = 0; pass < 1000; pass++) {
+      std::vector<double> data(m_queues.size(), 0), icmp(m_queues.size(), 0);
+      double atServer = 0;
+      for (std::size_t f : m_sources)
+        atServer += Send(m_flows[f], data, icmp);
+      for (std::size_t k = 0; k < m_sources.size(); k++) {
+        const Flow &up = m_flows[m_sources[k]];
+        m_flows[m_bounces[k]].rate = (1 - p) * up.delivered;
+        Send(m_flows[m_bounces[k]], data, icmp);
+      }
+      m_flows[m_forward].rate = p * atServer;
+      m_flows[m_icmp].rate = Send(m_flows[m_forward], data, icmp);
+      Send(m_flows[m_icmp], data, icmp);
+
+      m_estimates.clear();
+      double change = 0;
+      for (std::size_t q = 0; q < m_queues.size(); q++) {
+        const Queue &queue = m_queues[q];
+        std::vector<Traffic> own, shared;
+        own.push_back(Traffic(data[q], DataService(queue)));
+        own.push_back(Traffic(icmp[q], IcmpService(queue)));
+        if (m_config.link != "p2p") {
+          shared.push_back(Traffic(data[queue.peer], DataService(queue)));
+          shared.push_back(Traffic(icmp[queue.peer], IcmpService(queue)));
+        }
+        m_estimates.push_back(EstimateQueue(queue.name, own, shared,
+                                            queue.deviceQueue,
+                                            queue.queueDisc));
+        change = std::max(change, std::fabs(m_estimates[q].loss - m_loss[q]));
+        m_loss[q] = m_estimates[q].loss;
+      }
+      m_forwarded = p * atServer;
+      m_bounced = (1 - p) * atServer;
+      if (change < 1e-12)
+        break;
+    }
+
+    double delaySum = 0;
+    m_delivered = m_lost = 0;
+    for (const Flow &flow : m_flows) {
+      m_delivered += flow.delivered;
+      m_lost += flow.rate - flow.delivered;
+      delaySum += flow.delivered * PathDelay(flow);
+    }
+    m_meanDelay = m_delivered > 0 ? delaySum / m_delivered : 0;
+  }
+
+  // Adds the flow to the queues it reaches and returns what arrives.
+  double Send(Flow &flow, std::vector<double> &data,
+              std::vector<double> &icmp) const {
+    double rate = flow.rate;
+    for (int q : flow.path) {
+      (flow.icmp ? icmp : data)[q] += rate;
+      rate *= 1 - m_loss[q];
+    }
+    flow.delivered = rate;
+    return rate;
+  }
+
+  // Wait, transmission and propagation over the flow's path.
+  double PathDelay(const Flow &flow) const {
+    double delay = 0;
+    double propagation = Time(Part3Topology::DefaultDelay()).GetSeconds();
+    for (int q : flow.path) {
+      const Queue &queue = m_queues[q];
+      ServiceTime service =
+          flow.icmp ? IcmpService(queue) : DataService(queue);
+      delay += m_estimates[q].meanWait + service.mean + propagation;
+    }
+    return delay;
+  }
+
+  Part3Config m_config;
+  double m_forwardProbability;
+  double m_maxUtilisation, m_maxLoss;
+
+  std::vector<Queue> m_queues;
+  std::vector<Flow> m_flows;
+  std::vector<std::size_t> m_sources, m_bounces;
+  std::size_t m_forward, m_icmp;
+
+  std::vector<double> m_loss;
+  std::vector<QueueEstimate> m_estimates;
+  double m_meanDelay, m_delivered, m_lost, m_forwarded, m_bounced;
+};
+
+// --analytic: the model's estimates instead of a simulation. Every queue's
+// is printed, and the G-S predictions go into the summary under the
+// simulation's keys, with analytic_ok telling whether the model can be
+// trusted for this configuration.
+static int RunPart3Model(const Part3Config &config) {
+  Part3Model model(config);
+  model.Print(stdout);
+  if (!config.summary.empty()) {
+    RunSummary results;
+    model.Summarize(results);
+    results.Write(config.summary);
+  }
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* PART3_MODEL_H */
@@ -0,0 +1,359 @@
+#ifndef PART3_SCENARIO_H
+#define PART3_SCENARIO_H
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-helper.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#ifdef NS3_MPI
+#include "ns3/mpi-module.h"
+#endif
+
+#include "counting-scheduler.h"
+#include "exponential-traffic-source.h"
+#include "flow-stats-exporter.h"
+#include "flow-tally.h"
+#include "part3-config.h"
+#include "overflow-estimator.h"
+#include "part3-model.h"
+#include "part3-topology.h"
+#include "profiling-scheduler.h"
+#include "queue-monitor.h"
+#include "run-summary.h"
+#include "sampled-pcap.h"
+#include "sequential-stop.h"
+#include "server-reflector.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE("Part3Scenario");
+
+static Ptr<ExponentialTrafficSource> InstallSource(Ptr<Node> node,
+                                                   Address remote, double mean,
+                                                   double meanSize,
+                                                   int64_t stream,
+                                                   bool antithetic) {
+  Ptr<ExponentialTrafficSource> source =
+      CreateObject<ExponentialTrafficSource>();
+  source->SetAttribute("Remote", AddressValue(remote));
+  source->SetAttribute("MeanInterval", DoubleValue(mean));
+  source->SetAttribute("MeanSize", DoubleValue(meanSize));
+  source->SetAttribute("Antithetic", BooleanValue(antithetic));
+  source->AssignStreams(stream);
+  node->AddApplication(source);
+  return source;
+}
+
+// The device --capture calls label: gs and sg for G's and S's end of G-S,
+// gr and rg for G-R.
+static Ptr<NetDevice> CaptureDevice(const Part3Topology &topology,
+                                    std::string label) {
+  if (label == "gs" || label == "sg")
+    return topology.GetServerDevices().Get(label == "gs" ? 0 : 1);
+  if (label == "gr" || label == "rg")
+    return topology.GetRouterDevices().Get(label == "gr" ? 0 : 1);
+  NS_ABORT_MSG("--capture: unknown device " << label);
+  return 0;
+}
+
+// The part3 simulation: every source sends to S, which forwards 70% of what
+// it receives to R and bounces the rest back. argc and argv go to MPI.
+static int RunPart3(const Part3Config &config, int argc, char *argv[]) {
+  if (config.analytic)
+    return RunPart3Model(config);
+
+  // --distributed runs under ns-3's distributed simulator, one partition per
+  // MPI rank (see Part3Topology::SetRanks()), e.g.
+  //
+  //   mpirun -np 4 ./ns3.32-project-part3-p2p-debug --distributed
+  //       --nSources=1000 --nRouters=30 --summary=summary.txt
+  //
+  // Every stream is fixed per node, so the run gives the same summary as
+  // the sequential one. Rank 0 writes the summary and prints the results;
+  // the other files get a -rank<k> suffix.
+  uint32_t rank = 0, ranks = 1;
+  if (config.distributed) {
+#ifdef NS3_MPI
+    GlobalValue::Bind("SimulatorImplementationType",
+                      StringValue("ns3::DistributedSimulatorImpl"));
+    MpiInterface::Enable(&argc, &argv);
+    rank = MpiInterface::GetSystemId();
+    ranks = MpiInterface::GetSize();
+#else
+    NS_ABORT_MSG("--distributed needs ns-3 configured with --enable-mpi");
+#endif
+  }
+  std::string suffix = ranks > 1 ? "-rank" + std::to_string(rank) : "";
+
+  // The event set, wrapped for counting and profiling as asked.
+  std::string events = SchedulerTypeName(config.scheduler);
+  if (config.benchmark) {
+    Config::SetDefault("ns3::CountingScheduler::Inner", StringValue(events));
+    events = "ns3::CountingScheduler";
+  }
+  if (!config.profile.empty()) {
+    Config::SetDefault("ns3::ProfilingScheduler::Inner", StringValue(events));
+    Config::SetDefault("ns3::ProfilingScheduler::Output",
+                       StringValue(config.profile + suffix));
+    Config::SetDefault("ns3::ProfilingScheduler::Folded",
+                       BooleanValue(config.profileFolded));
+    events = "ns3::ProfilingScheduler";
+  }
+  ObjectFactory scheduler;
+  scheduler.SetTypeId(events);
+  Simulator::SetScheduler(scheduler);
+
+  NS_LOG_INFO("Create topology.");
+  Part3Topology topology(config.link);
+  topology.SetAccessRate(config.accessRate);
+  topology.SetCoreRate(config.coreRate);
+  topology.SetServerRate(config.serverRate);
+  topology.SetRanks(ranks);
+  topology.Build(config.nSources, config.nRouters);
+  NodeContainer local = topology.GetLocalNodes(rank);
+
+  // Assigning the addresses gave every device the default queue disc;
+  // G-S gets the FIFO the queue analysis is about instead.
+  TrafficControlHelper tch;
+  tch.Uninstall(topology.GetServerDevices());
+  tch.SetRootQueueDisc("ns3::FifoQueueDisc", "MaxSize",
+                       StringValue(config.queueSize + "p"));
+  QueueDiscContainer qdiscs = tch.Install(topology.GetServerDevices());
+
+  // Occupancy of both queue discs on the G-S link, <prefix>_gs.txt for G
+  // and <prefix>_sg.txt for S, written whenever it changes, and the
+  // statistics of G's for the summary. G and S are on rank 0.
+  std::string queuePrefix = config.link + "_queue";
+  QueueMonitor queueMonitor(config.queueTrace ? queuePrefix : "",
+                            config.binaryQueueTrace);
+  if (rank == 0) {
+    queueMonitor.WatchQueueDisc("gs", qdiscs.Get(0));
+    queueMonitor.WatchQueueDisc("sg", qdiscs.Get(1));
+    queueMonitor.WatchSojournTime("gs");
+  }
+  if (config.monitorAllQueues) {
+    queueMonitor.WatchAllQueueDiscs(local);
+    queueMonitor.WatchAllDeviceQueues(local);
+  }
+  if (config.queueSampleInterval > 0) {
+    queueMonitor.EnableSampling(Seconds(1.0),
+                                Seconds(config.queueSampleInterval),
+                                Seconds(config.simulationTime));
+  }
+
+  // With --stopPrecision the run ends once G-S's estimates are precise
+  // enough, simulationTime being the limit.
+  NS_ABORT_MSG_IF(config.stopPrecision > 0 && ranks > 1,
+                  "--stopPrecision needs a sequential run");
+  SequentialStop sequentialStop(queueMonitor, "gs", config.stopPrecision);
+  if (config.stopPrecision > 0)
+    sequentialStop.Start(Seconds(2.0), Seconds(config.stopInterval));
+
+  NS_LOG_INFO("Create Applications.");
+  uint16_t port = 9;
+  Ptr<ServerReflector> reflector;
+  if (rank == 0) {
+    UdpServerHelper serverHelper(port);
+    ApplicationContainer serverApps =
+        serverHelper.Install(topology.GetServer());
+    serverApps.Start(Seconds(1.0));
+    serverApps.Stop(Seconds(config.simulationTime));
+
+    // 70% of what S receives goes on to R, the rest back to its source.
+    TypeId tid = UdpSocketFactory::GetTypeId();
+    Ptr<Socket> forward = Socket::CreateSocket(topology.GetServer(), tid);
+    forward->Connect(InetSocketAddress(topology.GetRouterAddress(), port));
+    Ptr<Socket> bounce = Socket::CreateSocket(topology.GetServer(), tid);
+
+    // A stream per source keeps the decisions common across link types.
+    reflector = CreateObject<ServerReflector>();
+    reflector->SetAttribute("Antithetic", BooleanValue(config.antithetic));
+    reflector->AssignStreams(0);
+    int64_t decisionStreams = 1 + 2 * (int64_t)config.nSources;
+    for (uint32_t i = 0; i < config.nSources; i++)
+      reflector->AssignSourceStream(topology.GetSourceAddress(i),
+                                    decisionStreams + i);
+    reflector->Install(serverHelper.GetServer(), forward, bounce);
+  }
+
+  // Exponential payload and inter-transmission time on every source. Source
+  // i draws its gaps from stream 1 + 2i and its sizes from 2 + 2i, and S
+  // decides on its packets from stream 1 + 2n + i above, n being the number
+  // of sources, so runs with the same RngRun share their uniforms whatever
+  // the link type (see part3-sweep.cc --pairBy). --antithetic draws every
+  // one of them from 1 - U instead.
+  InetSocketAddress remote(topology.GetServerAddress(), port);
+  const double means[] = {config.meanA, config.meanB, config.meanC,
+                          config.meanD};
+  ApplicationContainer sourceApps;
+  std::vector<Ptr<ExponentialTrafficSource>> localSources;
+  NodeContainer sources = topology.GetSources();
+  for (uint32_t i = 0; i < sources.GetN(); i++) {
+    if (sources.Get(i)->GetSystemId() != rank)
+      continue;
+    localSources.push_back(InstallSource(sources.Get(i), remote, means[i % 4],
+                                         config.meanSize, 1 + 2 * (int64_t)i,
+                                         config.antithetic));
+    sourceApps.Add(localSources.back());
+  }
+  sourceApps.Start(Seconds(2.0));
+
+  // Importance sampling of G-S overflows needs every source at hand.
+  NS_ABORT_MSG_IF(config.overflowTwist > 0 && ranks > 1,
+                  "--overflowTwist needs a sequential run");
+  uint32_t overflowLevel = config.overflowLevel;
+  if (overflowLevel == 0)
+    overflowLevel = std::stoul(config.queueSize);
+  double twist = config.overflowTwist > 0 ? config.overflowTwist : 1;
+  OverflowEstimator overflow(qdiscs.Get(0), topology.GetServerDevices().Get(0),
+                             localSources, twist, overflowLevel);
+  if (config.overflowTwist > 0)
+    overflow.Start(Seconds(2.0));
+
+  if (config.enableTraces)
+    topology.EnableTraces("simple-global-routing" + suffix, local);
+
+  // Sampled captures of single devices, all of them on rank 0.
+  std::vector<Ptr<SampledPcap>> captures;
+  std::vector<std::string> captureLabels;
+  if (rank == 0 && !config.capture.empty()) {
+    std::stringstream list(config.capture);
+    std::string label;
+    while (std::getline(list, label, ',')) {
+      captures.push_back(Create<SampledPcap>(
+          CaptureDevice(topology, label),
+          config.link + "_capture_" + label + ".pcap", config.captureSampling,
+          config.captureSnapLen, Seconds(config.captureStart),
+          Seconds(config.captureStop)));
+      captureLabels.push_back(label);
+    }
+  }
+
+  FlowMonitorHelper flowmonHelper;
+  FlowTally flowTally;
+  Ptr<FlowStatsExporter> flowExporter;
+  if (config.enableFlowMonitor) {
+    Ptr<FlowMonitor> monitor = flowmonHelper.Install(local);
+    flowTally.Install(local);
+    if (config.flowStatsInterval > 0) {
+      flowExporter = Create<FlowStatsExporter>(
+          monitor,
+          DynamicCast<Ipv4FlowClassifier>(flowmonHelper.GetClassifier()),
+          "simple-global-routing" + suffix + ".flowstats.csv");
+      flowExporter->Start(Seconds(config.flowStatsInterval),
+                          Seconds(config.flowStatsInterval),
+                          Seconds(config.simulationTime));
+    }
+  }
+
+  NS_LOG_INFO("Run Simulation.");
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  Simulator::Stop(Seconds(config.simulationTime));
+  Simulator::Run();
+  double runSeconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  NS_LOG_INFO("Done.");
+
+  FlowTally::Totals flows = flowTally.GetTotals();
+  if (rank == 0) {
+    std::cout << "Server S: " << reflector->GetForwarded() << " forwarded, "
+              << reflector->GetBounced() << " bounced, "
+              << reflector->GetAllocationsPerPacket()
+              << " allocations per packet" << std::endl;
+    if (config.queueTrace)
+      queueMonitor.WriteHistogram("gs", queuePrefix + "_gs_hist.txt");
+    if (config.overflowTwist > 0)
+      std::cout << "G-S overflow: " << overflow.GetOverflowProbability()
+                << " +- " << overflow.GetOverflowHalfWidth()
+                << " per cycle over " << overflow.GetCycles()
+                << " cycles, drop probability "
+                << overflow.GetDropProbability() << " +- "
+                << overflow.GetDropHalfWidth() << std::endl;
+    for (std::size_t i = 0; i < captures.size(); i++)
+      std::cout << "Capture " << captureLabels[i] << ": "
+                << captures[i]->GetCaptured() << " of "
+                << captures[i]->GetSeen() << " packets" << std::endl;
+  }
+
+  if (rank == 0 && !config.summary.empty()) {
+    RunSummary results;
+    results.Set("queue_mean_packets", queueMonitor.GetMeanPackets("gs"));
+    results.Set("queue_var_packets", queueMonitor.GetVariancePackets("gs"));
+    results.Set("queue_max_packets", queueMonitor.GetMaxPackets("gs"));
+    results.Set("queue_p50_packets",
+                queueMonitor.GetPacketsQuantile("gs", 0.5));
+    results.Set("queue_p99_packets",
+                queueMonitor.GetPacketsQuantile("gs", 0.99));
+    results.Set("queue_p999_packets",
+                queueMonitor.GetPacketsQuantile("gs", 0.999));
+    results.Set("sojourn_mean", queueMonitor.GetMeanSojourn("gs"));
+    results.Set("sojourn_p50", queueMonitor.GetSojournQuantile("gs", 0.5));
+    results.Set("sojourn_p99", queueMonitor.GetSojournQuantile("gs", 0.99));
+    results.Set("sojourn_p999",
+                queueMonitor.GetSojournQuantile("gs", 0.999));
+    results.Set("forwarded", reflector->GetForwarded());
+    results.Set("bounced", reflector->GetBounced());
+    results.Set("allocs_per_packet", reflector->GetAllocationsPerPacket());
+    results.Set("run_seconds", runSeconds);
+    if (config.stopPrecision > 0) {
+      const BatchMeans &packets = sequentialStop.GetPackets();
+      const BatchMeans &sojourn = sequentialStop.GetSojourn();
+      results.Set("stop_time", Simulator::Now().GetSeconds());
+      results.Set("converged", sequentialStop.HasConverged());
+      results.Set("warmup_seconds", sequentialStop.GetWarmup().GetSeconds());
+      results.Set("steady_queue_mean_packets", packets.GetMean());
+      results.Set("steady_queue_half_width", packets.GetHalfWidth());
+      results.Set("steady_sojourn_mean", sojourn.GetMean());
+      results.Set("steady_sojourn_half_width", sojourn.GetHalfWidth());
+    }
+    if (config.overflowTwist > 0) {
+      results.Set("overflow_cycles", overflow.GetCycles());
+      results.Set("overflow_hits", overflow.GetOverflows());
+      results.Set("overflow_probability", overflow.GetOverflowProbability());
+      results.Set("overflow_half_width", overflow.GetOverflowHalfWidth());
+      results.Set("drop_probability", overflow.GetDropProbability());
+      results.Set("drop_half_width", overflow.GetDropHalfWidth());
+    }
+    if (config.benchmark) {
+      uint64_t events = Simulator::GetEventCount();
+      results.Set("events", events);
+      results.Set("events_per_second", runSeconds > 0 ? events / runSeconds
+                                                      : 0);
+      results.Set("peak_event_set", CountingScheduler::GetPeakSize());
+      results.Set("peak_rss_kb", PeakRssKilobytes());
+    }
+    if (config.enableFlowMonitor)
+      results.SetFlowStats(flows);
+    results.Write(config.summary);
+  }
+
+  if (flowExporter) {
+    flowExporter->Finish();
+  } else if (config.enableFlowMonitor) {
+    flowmonHelper.SerializeToXmlFile(
+        "simple-global-routing" + suffix + ".flowmon", false, false);
+  }
+
+  Simulator::Destroy();
+#ifdef NS3_MPI
+  if (config.distributed)
+    MpiInterface::Disable();
+#endif
+  return 0;
+}
+
+} // namespace ns3
+
+#endif /* PART3_SCENARIO_H */
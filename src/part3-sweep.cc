@@ -0,0 +1,578 @@
+#include "ns3/core-module.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "batch-means.h"
+#include "part3-config.h"
+
+// Runs part3 replications and parameter sweeps as separate processes, in
+// parallel, and aggregates their summaries (see run-summary.h).
+//
+// The spec is a text file of "key = value, value, ..." lines; '#' starts a
+// comment:
+//
+//   link = p2p, csma
+//   RngRun = 1-30
+//   meanC = 0.0005, 0.00025
+//   queueSize = 100, 1000
+//   simulationTime = 60
+//   enableTraces = false
+//
+// Every combination of the listed values is one configuration, and the
+// RngRun values (a-b is a range) are its replications. link picks the
+// program; every other key is passed on as --key=value, so any flag of
+// project-part3-p2p/csma can be swept, ns-3 globals such as RngSeed
+// included.
+//
+// Each run gets its own directory, <workDir>/<index>/, so the trace files
+// of concurrent runs do not collide; the program's output goes to log.txt
+// there and its results to summary.txt. The result file has one row per
+// configuration and summary key:
+//
+//   <swept keys...> metric n mean variance ci95_low ci95_high
+//
+// with the interval mean +- t(0.975, n - 1) * sqrt(variance / n).
+//
+// With --analyticTolerance=<t> the queueing model (part3-model.h) is
+// checked against a pilot: each configuration gets a --analytic run and its
+// first replication, a full simulation. Where the model trusts itself and
+// its analyticKeys (by default the delay, the forwarded and bounced counts
+// and the G-S queue's mean length and sojourn) are within t of the pilot,
+// relative to the larger value, the other replications are not run and the
+// model's summary is the result, written with n = 0. The pilot is always
+// simulated, so with n replications a configuration saves at most
+// (n - 1) / n of its simulation time, and nothing with n = 1. The
+// configurations the model cannot answer, near saturation or with the
+// buffers filling, run all their replications.
+//
+// With --antithetic each replication is a pair of runs, the second with
+// --antithetic=true, and their mean is one observation, so n counts pairs.
+// With --pairBy=<key> every configuration is also compared with the one
+// that has the key's first value and otherwise the same values, one
+// difference per RngRun, into the differences file; the key's column reads
+// e.g. csma-p2p. The programs draw every source's traffic and S's decisions
+// for it from streams of their own (see RunPart3()), so the runs being
+// compared share their uniforms, though not necessarily their packets: a
+// different meanSize turns the same uniforms into other sizes. The
+// difference's interval is still much narrower than the two means' would
+// suggest.
+//
+// The p2p and csma programs default to different packet sizes and
+// simulation times (see Part3Config). When the spec lists both links and
+// leaves meanSize or simulationTime out, both programs are run with the p2p
+// defaults, so that the links are all that differ between them.
+//
+// The programs are executed directly, so start the sweep through waf to get
+// the library path:
+//
+//   ./waf --run "part3-sweep --spec=sweep.txt --jobs=16"
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Part3Sweep");
+
+typedef std::vector<std::pair<std::string, std::vector<std::string>>> Spec;
+
+struct Run {
+  std::string program;
+  std::vector<std::string> args;
+  std::string rngRun;
+  int config;
+  std::size_t replication; // index into the RngRun values
+  bool antithetic;
+  std::string dir;
+  bool launched, ok;
+  std::vector<std::pair<std::string, double>> results;
+};
+
+// Welford's running mean and variance.
+struct Accumulator {
+  Accumulator() : n(0), mean(0), m2(0) {}
+
+  void Add(double x) {
+    n++;
+    double delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+  }
+
+  uint64_t n;
+  double mean, m2;
+};
+
+// One replication's results: a run's summary, or the mean of a run and its
+// antithetic twin.
+typedef std::map<std::string, double> Observation;
+
+static std::string Trim(std::string text) {
+  const char *space = " \t\r\n";
+  std::string::size_type begin = text.find_first_not_of(space);
+  if (begin == std::string::npos)
+    return "";
+  return text.substr(begin, text.find_last_not_of(space) - begin + 1);
+}
+
+static Spec ReadSpec(std::string filename) {
+  std::ifstream in(filename);
+  NS_ABORT_MSG_IF(!in.is_open(), "part3-sweep: cannot open " << filename);
+
+  Spec spec;
+  std::string line;
+  while (std::getline(in, line)) {
+    line = Trim(line.substr(0, line.find('#')));
+    if (line.empty())
+      continue;
+
+    std::string::size_type eq = line.find('=');
+    NS_ABORT_MSG_IF(eq == std::string::npos,
+                    "part3-sweep: expected key = values in '" << line << "'");
+    std::string key = Trim(line.substr(0, eq));
+    std::vector<std::string> values;
+    std::stringstream list(line.substr(eq + 1));
+    std::string value;
+    while (std::getline(list, value, ','))
+      if (!Trim(value).empty())
+        values.push_back(Trim(value));
+    NS_ABORT_MSG_IF(key.empty() || values.empty(),
+                    "part3-sweep: empty key or values in '" << line << "'");
+    spec.push_back(std::make_pair(key, values));
+  }
+  return spec;
+}
+
+// "1-3, 7" -> 1, 2, 3, 7
+static std::vector<std::string> ExpandRanges(std::vector<std::string> values) {
+  std::vector<std::string> out;
+  for (const std::string &value : values) {
+    std::string::size_type dash = value.find('-', 1);
+    if (dash == std::string::npos) {
+      out.push_back(value);
+      continue;
+    }
+    uint64_t first = std::stoull(value.substr(0, dash));
+    uint64_t last = std::stoull(value.substr(dash + 1));
+    for (uint64_t run = first; run <= last; run++)
+      out.push_back(std::to_string(run));
+  }
+  return out;
+}
+
+// With more than one link in the spec, gives meanSize and simulationTime
+// the p2p program's defaults unless the spec sets them, so the programs
+// differ in the link only.
+static void PinLinkDefaults(Spec &spec) {
+  std::size_t links = 0;
+  bool meanSize = false, simulationTime = false;
+  for (const auto &entry : spec) {
+    if (entry.first == "link")
+      links = entry.second.size();
+    meanSize = meanSize || entry.first == "meanSize";
+    simulationTime = simulationTime || entry.first == "simulationTime";
+  }
+  if (links < 2)
+    return;
+
+  Part3Config p2p("p2p");
+  auto pin = [&spec](std::string key, double value) {
+    std::ostringstream text;
+    text << value;
+    spec.push_back(
+        std::make_pair(key, std::vector<std::string>(1, text.str())));
+    std::cout << "both links run with " << key << " = " << text.str()
+              << std::endl;
+  };
+  if (!meanSize)
+    pin("meanSize", p2p.meanSize);
+  if (!simulationTime)
+    pin("simulationTime", p2p.simulationTime);
+}
+
+static void MakeDirectory(std::string path) {
+  NS_ABORT_MSG_IF(mkdir(path.c_str(), 0755) != 0 && errno != EEXIST,
+                  "part3-sweep: cannot create " << path);
+}
+
+static pid_t Launch(const Run &run) {
+  pid_t pid = fork();
+  NS_ABORT_MSG_IF(pid < 0, "part3-sweep: fork failed");
+  if (pid > 0)
+    return pid;
+
+  // Child: run inside the run's directory with the output in log.txt.
+  int log = open((run.dir + "/log.txt").c_str(),
+                 O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log < 0 || chdir(run.dir.c_str()) != 0)
+    _exit(127);
+  dup2(log, STDOUT_FILENO);
+  dup2(log, STDERR_FILENO);
+  close(log);
+
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>(run.program.c_str()));
+  for (const std::string &arg : run.args)
+    argv.push_back(const_cast<char *>(arg.c_str()));
+  argv.push_back(0);
+  execv(run.program.c_str(), argv.data());
+  _exit(127);
+}
+
+static bool ReadSummary(std::string filename,
+                        std::vector<std::pair<std::string, double>> &results) {
+  std::ifstream in(filename);
+  std::string key;
+  double value;
+  while (in >> key >> value)
+    results.push_back(std::make_pair(key, value));
+  return !results.empty();
+}
+
+// Runs the listed runs, up to jobs at a time, and returns how many failed.
+static std::size_t RunAll(std::vector<Run> &runs,
+                          const std::vector<std::size_t> &which, int jobs) {
+  std::map<pid_t, std::size_t> running;
+  std::size_t next = 0, done = 0, failed = 0;
+  while (done < which.size()) {
+    while (next < which.size() && (int)running.size() < jobs) {
+      running[Launch(runs[which[next]])] = which[next];
+      next++;
+    }
+
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      NS_ABORT_MSG_IF(errno != EINTR, "part3-sweep: waitpid failed");
+      continue;
+    }
+    std::size_t i = running[pid];
+    running.erase(pid);
+    done++;
+
+    Run &run = runs[i];
+    run.launched = true;
+    run.ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+             ReadSummary(run.dir + "/summary.txt", run.results);
+    if (!run.ok) {
+      failed++;
+      std::cerr << "run " << i << " (RngRun " << run.rngRun
+                << ") failed, see " << run.dir << "/log.txt" << std::endl;
+    }
+    std::cout << "\r" << done << "/" << which.size() << " runs"
+              << std::flush;
+  }
+  std::cout << std::endl;
+  return failed;
+}
+
+static double Find(const Run &run, std::string key) {
+  for (const auto &result : run.results)
+    if (result.first == key)
+      return result.second;
+  return NAN;
+}
+
+// Whether the model run trusts itself and each of keys is within tolerance
+// of the pilot run's value. Values below 1e-9 count as 0.
+static bool Agrees(const Run &model, const Run &pilot,
+                   const std::vector<std::string> &keys, double tolerance) {
+  if (!model.ok || !pilot.ok || Find(model, "analytic_ok") != 1)
+    return false;
+  for (const std::string &key : keys) {
+    double m = Find(model, key), s = Find(pilot, key);
+    double scale = std::max(std::fabs(m), std::fabs(s));
+    if (!(std::fabs(m - s) <= tolerance * scale || scale < 1e-9))
+      return false;
+  }
+  return true;
+}
+
+// "<values...> metric n mean variance ci95_low ci95_high"; n = 0 marks the
+// model's figures, which have no interval.
+static void WriteRow(std::FILE *out, const std::vector<std::string> &values,
+                     std::string metric, const Accumulator &a, bool model) {
+  uint64_t n = model ? 0 : a.n;
+  double variance = n > 1 ? a.m2 / (n - 1) : NAN;
+  double half = n ? StudentT975(n - 1) * std::sqrt(variance / n) : NAN;
+  for (const std::string &value : values)
+    std::fprintf(out, "%s ", value.c_str());
+  std::fprintf(out, "%s %llu %.10g %.10g %.10g %.10g\n", metric.c_str(),
+               (unsigned long long)n, a.mean, variance, a.mean - half,
+               a.mean + half);
+}
+
+int main(int argc, char *argv[]) {
+  std::string specFile;
+  std::string output = "part3-sweep-results.txt";
+  std::string workDir = "part3-sweep";
+  std::string programs = "build/scratch/ns3.32-project-part3-{link}-debug";
+  int jobs = std::thread::hardware_concurrency();
+  double analyticTolerance = 0;
+  std::string analyticKeys =
+      "delay_mean,forwarded,bounced,queue_mean_packets,sojourn_mean";
+  bool antithetic = false;
+  std::string pairBy;
+  std::string differences = "part3-sweep-differences.txt";
+
+  CommandLine cmd(__FILE__);
+  cmd.AddValue("spec", "Sweep specification", specFile);
+  cmd.AddValue("output", "Aggregated results", output);
+  cmd.AddValue("workDir", "Directory for the individual runs", workDir);
+  cmd.AddValue("programs", "Program path, {link} is replaced by p2p or csma",
+               programs);
+  cmd.AddValue("jobs", "Number of runs at a time", jobs);
+  cmd.AddValue("analyticTolerance",
+               "Use the queueing model where it agrees with the first "
+               "replication to this relative tolerance, 0 never",
+               analyticTolerance);
+  cmd.AddValue("analyticKeys", "Summary keys the model has to agree on",
+               analyticKeys);
+  cmd.AddValue("antithetic",
+               "Run every replication with its antithetic twin and take "
+               "the pair's mean",
+               antithetic);
+  cmd.AddValue("pairBy",
+               "Swept key whose values are compared replication by "
+               "replication",
+               pairBy);
+  cmd.AddValue("differences", "Paired differences, with --pairBy",
+               differences);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(specFile.empty(), "part3-sweep: --spec is required");
+  jobs = std::max(jobs, 1);
+
+  // Split the spec into the swept keys and the replications.
+  Spec swept;
+  std::vector<std::string> rngRuns(1, "1");
+  for (const auto &entry : ReadSpec(specFile)) {
+    if (entry.first == "RngRun")
+      rngRuns = ExpandRanges(entry.second);
+    else
+      swept.push_back(entry);
+  }
+  bool hasLink = false;
+  for (const auto &entry : swept)
+    hasLink = hasLink || entry.first == "link";
+  if (!hasLink) {
+    std::vector<std::string> p2p(1, "p2p");
+    swept.insert(swept.begin(), std::make_pair(std::string("link"), p2p));
+  }
+  PinLinkDefaults(swept);
+
+  // Every combination of the swept values, the first key varying slowest.
+  std::vector<std::vector<std::string>> configs(1);
+  for (const auto &entry : swept) {
+    std::vector<std::vector<std::string>> next;
+    for (const auto &config : configs) {
+      for (const std::string &value : entry.second) {
+        next.push_back(config);
+        next.back().push_back(value);
+      }
+    }
+    configs.swap(next);
+  }
+
+  MakeDirectory(workDir);
+  std::vector<Run> runs;
+  std::vector<std::vector<std::size_t>> replications(configs.size());
+  for (std::size_t c = 0; c < configs.size(); c++) {
+    for (std::size_t r = 0; r < rngRuns.size(); r++) {
+      for (int twin = 0; twin < (antithetic ? 2 : 1); twin++) {
+        Run run;
+        run.config = c;
+        run.replication = r;
+        run.rngRun = rngRuns[r];
+        run.antithetic = twin;
+        run.launched = run.ok = false;
+        run.dir = workDir + "/" + std::to_string(runs.size());
+        run.args.push_back("--RngRun=" + rngRuns[r]);
+        run.args.push_back("--summary=summary.txt");
+        if (twin)
+          run.args.push_back("--antithetic=true");
+        std::string link;
+        for (std::size_t k = 0; k < swept.size(); k++) {
+          if (swept[k].first == "link")
+            link = configs[c][k];
+          else
+            run.args.push_back("--" + swept[k].first + "=" + configs[c][k]);
+        }
+
+        std::string program = programs;
+        std::string::size_type at = program.find("{link}");
+        if (at != std::string::npos)
+          program.replace(at, 6, link);
+        char resolved[PATH_MAX];
+        NS_ABORT_MSG_IF(!realpath(program.c_str(), resolved),
+                        "part3-sweep: no program " << program);
+        run.program = resolved;
+
+        MakeDirectory(run.dir);
+        replications[c].push_back(runs.size());
+        runs.push_back(run);
+      }
+    }
+  }
+
+  // The model's runs, after the replications so those keep their
+  // directories, and which configurations it answers.
+  std::vector<std::size_t> models;
+  std::vector<bool> modelled(configs.size(), false);
+  std::size_t launched = 0, failed = 0;
+  if (analyticTolerance > 0) {
+    std::vector<std::string> keys;
+    std::stringstream list(analyticKeys);
+    std::string key;
+    while (std::getline(list, key, ','))
+      if (!Trim(key).empty())
+        keys.push_back(Trim(key));
+
+    std::vector<std::size_t> first;
+    for (std::size_t c = 0; c < configs.size(); c++) {
+      Run run = runs[replications[c][0]];
+      run.dir = workDir + "/" + std::to_string(runs.size());
+      run.args.push_back("--analytic=true");
+      MakeDirectory(run.dir);
+      models.push_back(runs.size());
+      first.push_back(runs.size());
+      first.push_back(replications[c][0]);
+      runs.push_back(run);
+    }
+    failed += RunAll(runs, first, jobs);
+    launched += first.size();
+
+    std::size_t answered = 0;
+    for (std::size_t c = 0; c < configs.size(); c++) {
+      modelled[c] = Agrees(runs[models[c]], runs[replications[c][0]], keys,
+                           analyticTolerance);
+      answered += modelled[c];
+    }
+    std::cout << "the model answers " << answered << " of " << configs.size()
+              << " configurations" << std::endl;
+  }
+
+  std::vector<std::size_t> rest;
+  for (std::size_t c = 0; c < configs.size(); c++) {
+    for (std::size_t i : replications[c])
+      if (!modelled[c] && !runs[i].launched)
+        rest.push_back(i);
+  }
+  failed += RunAll(runs, rest, jobs);
+  launched += rest.size();
+
+  // One observation per configuration and replication, empty unless all
+  // its runs succeeded, and the summary keys in the order first seen.
+  std::vector<std::string> metrics;
+  std::vector<std::vector<Observation>> observations(
+      configs.size(), std::vector<Observation>(rngRuns.size()));
+  for (std::size_t c = 0; c < configs.size(); c++) {
+    if (modelled[c])
+      continue;
+    for (std::size_t r = 0; r < rngRuns.size(); r++) {
+      std::vector<const Run *> group;
+      bool complete = true;
+      for (std::size_t i : replications[c]) {
+        if (runs[i].replication == r) {
+          group.push_back(&runs[i]);
+          complete = complete && runs[i].ok;
+        }
+      }
+      if (!complete)
+        continue;
+      Observation &observation = observations[c][r];
+      for (const Run *run : group)
+        for (const auto &result : run->results)
+          observation[result.first] += result.second / group.size();
+      for (const auto &result : group[0]->results)
+        if (std::find(metrics.begin(), metrics.end(), result.first) ==
+            metrics.end())
+          metrics.push_back(result.first);
+    }
+  }
+  for (std::size_t m : models)
+    for (const auto &result : runs[m].results)
+      if (std::find(metrics.begin(), metrics.end(), result.first) ==
+          metrics.end())
+        metrics.push_back(result.first);
+
+  std::FILE *out = std::fopen(output.c_str(), "w");
+  NS_ABORT_MSG_IF(!out, "part3-sweep: cannot open " << output);
+  for (const auto &entry : swept)
+    std::fprintf(out, "%s ", entry.first.c_str());
+  std::fprintf(out, "metric n mean variance ci95_low ci95_high\n");
+  for (std::size_t c = 0; c < configs.size(); c++) {
+    std::map<std::string, Accumulator> stats;
+    if (modelled[c]) {
+      for (const auto &result : runs[models[c]].results)
+        stats[result.first].Add(result.second);
+    }
+    for (const Observation &observation : observations[c])
+      for (const auto &result : observation)
+        stats[result.first].Add(result.second);
+    for (const std::string &metric : metrics)
+      if (stats.count(metric))
+        WriteRow(out, configs[c], metric, stats[metric], modelled[c]);
+  }
+  std::fclose(out);
+
+  // Each configuration against the one with the first value of pairBy and
+  // otherwise the same values, replication by replication: with common
+  // random numbers the pairs are positively correlated and the difference
+  // has a much tighter interval than the two means would suggest.
+  if (!pairBy.empty()) {
+    std::size_t k = 0;
+    while (k < swept.size() && swept[k].first != pairBy)
+      k++;
+    NS_ABORT_MSG_IF(k == swept.size(),
+                    "part3-sweep: --pairBy=" << pairBy << " is not swept");
+    std::map<std::vector<std::string>, std::size_t> index;
+    for (std::size_t c = 0; c < configs.size(); c++)
+      index[configs[c]] = c;
+
+    out = std::fopen(differences.c_str(), "w");
+    NS_ABORT_MSG_IF(!out, "part3-sweep: cannot open " << differences);
+    for (const auto &entry : swept)
+      std::fprintf(out, "%s ", entry.first.c_str());
+    std::fprintf(out, "metric n mean variance ci95_low ci95_high\n");
+    for (std::size_t c = 0; c < configs.size(); c++) {
+      std::vector<std::string> reference = configs[c];
+      reference[k] = swept[k].second[0];
+      if (reference == configs[c])
+        continue;
+      std::size_t base = index[reference];
+
+      std::map<std::string, Accumulator> stats;
+      for (std::size_t r = 0; r < rngRuns.size(); r++) {
+        const Observation &a = observations[c][r];
+        const Observation &b = observations[base][r];
+        for (const auto &result : a)
+          if (b.count(result.first))
+            stats[result.first].Add(result.second - b.at(result.first));
+      }
+      std::vector<std::string> values = configs[c];
+      values[k] = configs[c][k] + "-" + reference[k];
+      for (const std::string &metric : metrics)
+        if (stats.count(metric))
+          WriteRow(out, values, metric, stats[metric], false);
+    }
+    std::fclose(out);
+  }
+
+  std::cout << launched - failed << " of " << launched
+            << " runs succeeded, results in " << output << std::endl;
+  return failed ? 1 : 0;
+}
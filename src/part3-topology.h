@@ -0,0 +1,286 @@
+#ifndef PART3_TOPOLOGY_H
+#define PART3_TOPOLOGY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+namespace ns3 {
+
+// Builds the part3 access/aggregation/gateway/server tree:
+//
+//   source --+                    +-- S (server)
+//   source --+-- router --+       |
+//   source --+-- router --+-- G --+-- R
+//   source -------------------+
+//
+// Sources hang off aggregation routers or directly off the gateway G, which
+// connects to the server S and to R. With the classic layout (4 sources, 2
+// routers) this is the original A-E-G, B/C-F-G, D-G network. Otherwise
+// source i goes to router i % routers, or straight to G if there are none.
+//
+// Links are point-to-point or CSMA, one /24 each, allocated automatically.
+// The gateway, S, R, router uplinks and direct sources come first, from
+// 10.1.0.0 up. Each router's sources get an aligned power-of-two block of
+// /24s after that, so the gateway reaches all of them through one static
+// route per router. Every other node has a single default route. Routing
+// state therefore grows linearly with the number of sources, where global
+// routing keeps a route to every subnet on every node.
+//
+// SetRanks() partitions the nodes for ns-3's distributed simulator: G, S
+// and R stay on rank 0, and each router, with its sources, and each direct
+// source goes to one of the other ranks in turn. The links between ranks are
+// router uplinks and direct source links, all point-to-point, and their
+// delay is the lookahead. MpiInterface has to be enabled before Build().
+class Part3Topology {
+public:
+  Part3Topology(std::string linkType)
+      : m_linkType(linkType), m_accessRate("5Mbps"), m_coreRate("8Mbps"),
+        m_serverRate("10Mbps"), m_delay(DefaultDelay()),
+        m_deviceQueue(DefaultDeviceQueue()),
+        m_serverDeviceQueue(DefaultServerDeviceQueue()), m_ranks(1) {
+    NS_ABORT_MSG_IF(linkType != "p2p" && linkType != "csma",
+                    "Part3Topology: unknown link type " << linkType);
+  }
+
+  // Source links and the classic layout's E-G uplink.
+  void SetAccessRate(std::string rate) { m_accessRate = rate; }
+  // Router uplinks and G-R.
+  void SetCoreRate(std::string rate) { m_coreRate = rate; }
+  void SetServerRate(std::string rate) { m_serverRate = rate; }
+  // Device queue sizes, e.g. "10p".
+  void SetDeviceQueue(std::string size) { m_deviceQueue = size; }
+  void SetServerDeviceQueue(std::string size) { m_serverDeviceQueue = size; }
+
+  void SetRanks(uint32_t ranks) {
+    NS_ABORT_MSG_IF(ranks == 0, "Part3Topology: no ranks");
+    NS_ABORT_MSG_IF(ranks > 1 && m_linkType != "p2p",
+                    "Part3Topology: CSMA links cannot cross ranks");
+    m_ranks = ranks;
+  }
+
+  // Every link's delay.
+  static std::string DefaultDelay() { return "2ms"; }
+  static std::string DefaultDeviceQueue() { return "10p"; }
+  // SetQueue() keeps the MaxSize set before it, so the original G-S device
+  // was 10p on both link types too.
+  static std::string DefaultServerDeviceQueue() { return "10p"; }
+
+  static bool IsClassic(uint32_t sources, uint32_t routers) {
+    return sources == 4 && routers == 2;
+  }
+
+  // The router each source is attached to, -1 for G.
+  static std::vector<int> Attachment(uint32_t sources, uint32_t routers) {
+    std::vector<int> attach(sources, -1);
+    for (uint32_t i = 0; i < sources && routers > 0; i++)
+      attach[i] = i % routers;
+    if (IsClassic(sources, routers)) {
+      attach[0] = 0;  // A-E
+      attach[1] = 1;  // B-F
+      attach[2] = 1;  // C-F
+      attach[3] = -1; // D-G
+    }
+    return attach;
+  }
+
+  void Build(uint32_t sources, uint32_t routers) {
+    NS_ABORT_MSG_IF(sources == 0, "Part3Topology: no sources");
+
+    bool classic = IsClassic(sources, routers);
+    std::vector<int> attach = Attachment(sources, routers);
+
+    m_gateway = CreateObject<Node>(0);
+    m_server = CreateObject<Node>(0);
+    m_router = CreateObject<Node>(0);
+    for (uint32_t r = 0; r < routers; r++)
+      m_routers.Add(CreateObject<Node>(RankOf(r)));
+    for (uint32_t i = 0, direct = routers; i < sources; i++) {
+      uint32_t rank = attach[i] >= 0 ? RankOf(attach[i]) : RankOf(direct++);
+      m_sources.Add(CreateObject<Node>(rank));
+    }
+    m_nodes.Add(m_gateway);
+    m_nodes.Add(m_server);
+    m_nodes.Add(m_router);
+    m_nodes.Add(m_routers);
+    m_nodes.Add(m_sources);
+
+    InternetStackHelper internet;
+    internet.Install(m_nodes);
+
+    m_sourceAddresses.resize(sources);
+
+    // The core region: G-S, G-R, the uplinks and the direct sources.
+    uint32_t subnet = 256;
+    m_serverDevices = Connect(m_gateway, m_server, m_serverRate,
+                              m_serverDeviceQueue);
+    Ipv4InterfaceContainer serverIf = Assign(m_serverDevices, subnet++);
+    m_serverAddress = serverIf.GetAddress(1);
+    SetDefaultRoute(m_server, m_serverDevices.Get(1), serverIf.GetAddress(0));
+
+    m_routerDevices = Connect(m_gateway, m_router, m_coreRate, m_deviceQueue);
+    Ipv4InterfaceContainer routerIf = Assign(m_routerDevices, subnet++);
+    m_routerAddress = routerIf.GetAddress(1);
+    SetDefaultRoute(m_router, m_routerDevices.Get(1), routerIf.GetAddress(0));
+
+    std::vector<NetDeviceContainer> uplinks(routers);
+    std::vector<Ipv4InterfaceContainer> uplinkIfs(routers);
+    for (uint32_t r = 0; r < routers; r++) {
+      std::string rate = classic && r == 0 ? m_accessRate : m_coreRate;
+      uplinks[r] = Connect(m_routers.Get(r), m_gateway, rate, m_deviceQueue);
+      uplinkIfs[r] = Assign(uplinks[r], subnet++);
+      SetDefaultRoute(m_routers.Get(r), uplinks[r].Get(0),
+                      uplinkIfs[r].GetAddress(1));
+    }
+
+    for (uint32_t i = 0; i < sources; i++) {
+      if (attach[i] >= 0)
+        continue;
+      NetDeviceContainer devices = Connect(m_sources.Get(i), m_gateway,
+                                           m_accessRate, m_deviceQueue);
+      Ipv4InterfaceContainer ifs = Assign(devices, subnet++);
+      m_sourceAddresses[i] = ifs.GetAddress(0);
+      SetDefaultRoute(m_sources.Get(i), devices.Get(0), ifs.GetAddress(1));
+    }
+
+    // One aligned block per router.
+    Ipv4StaticRoutingHelper staticRouting;
+    Ptr<Ipv4StaticRouting> gatewayRouting =
+        staticRouting.GetStaticRouting(m_gateway->GetObject<Ipv4>());
+    for (uint32_t r = 0; r < routers; r++) {
+      uint32_t count = 0;
+      for (uint32_t i = 0; i < sources; i++)
+        count += attach[i] == (int)r;
+      if (count == 0)
+        continue;
+
+      uint32_t block = 1, bits = 0;
+      while (block < count)
+        block <<= 1, bits++;
+      subnet = (subnet + block - 1) / block * block;
+
+      gatewayRouting->AddNetworkRouteTo(
+          SubnetAddress(subnet), Ipv4Mask(~0u << (8 + bits)),
+          uplinkIfs[r].GetAddress(0), InterfaceOf(uplinks[r].Get(1)));
+
+      for (uint32_t i = 0; i < sources; i++) {
+        if (attach[i] != (int)r)
+          continue;
+        NetDeviceContainer devices = Connect(
+            m_sources.Get(i), m_routers.Get(r), m_accessRate, m_deviceQueue);
+        Ipv4InterfaceContainer ifs = Assign(devices, subnet++);
+        m_sourceAddresses[i] = ifs.GetAddress(0);
+        SetDefaultRoute(m_sources.Get(i), devices.Get(0), ifs.GetAddress(1));
+      }
+    }
+  }
+
+  NodeContainer GetNodes() const { return m_nodes; }
+  Ptr<Node> GetGateway() const { return m_gateway; }
+  Ptr<Node> GetServer() const { return m_server; }
+  Ptr<Node> GetRouter() const { return m_router; }
+  NodeContainer GetSources() const { return m_sources; }
+  NodeContainer GetAggregationRouters() const { return m_routers; }
+
+  // The nodes the given rank simulates.
+  NodeContainer GetLocalNodes(uint32_t rank) const {
+    NodeContainer local;
+    for (uint32_t i = 0; i < m_nodes.GetN(); i++)
+      if (m_nodes.Get(i)->GetSystemId() == rank)
+        local.Add(m_nodes.Get(i));
+    return local;
+  }
+
+  // G-S, the gateway's device first.
+  NetDeviceContainer GetServerDevices() const { return m_serverDevices; }
+  // G-R, the gateway's device first.
+  NetDeviceContainer GetRouterDevices() const { return m_routerDevices; }
+  Ipv4Address GetServerAddress() const { return m_serverAddress; }
+  Ipv4Address GetRouterAddress() const { return m_routerAddress; }
+  Ipv4Address GetSourceAddress(uint32_t i) const {
+    return m_sourceAddresses[i];
+  }
+
+  // Ascii and pcap traces of every device on the given nodes.
+  void EnableTraces(std::string prefix, NodeContainer nodes) {
+    AsciiTraceHelper ascii;
+    if (m_linkType == "p2p") {
+      m_p2p.EnableAscii(ascii.CreateFileStream(prefix + ".tr"), nodes);
+      m_p2p.EnablePcap(prefix, nodes);
+    } else {
+      m_csma.EnableAscii(ascii.CreateFileStream(prefix + ".tr"), nodes);
+      m_csma.EnablePcap(prefix, nodes);
+    }
+  }
+
+private:
+  NetDeviceContainer Connect(Ptr<Node> a, Ptr<Node> b, std::string rate,
+                             std::string queue) {
+    if (m_linkType == "p2p") {
+      m_p2p.SetDeviceAttribute("DataRate", StringValue(rate));
+      m_p2p.SetChannelAttribute("Delay", StringValue(m_delay));
+      m_p2p.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue(queue));
+      return m_p2p.Install(a, b);
+    }
+    m_csma.SetChannelAttribute("DataRate", DataRateValue(DataRate(rate)));
+    m_csma.SetChannelAttribute("Delay", TimeValue(Time(m_delay)));
+    m_csma.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue(queue));
+    return m_csma.Install(NodeContainer(a, b));
+  }
+
+  // Rank of the k-th router or direct source.
+  uint32_t RankOf(uint32_t k) const {
+    return m_ranks > 1 ? 1 + k % (m_ranks - 1) : 0;
+  }
+
+  // Subnet k is 10.(k >> 8).(k & 255).0/24.
+  static Ipv4Address SubnetAddress(uint32_t subnet) {
+    return Ipv4Address((10u << 24) | (subnet << 8));
+  }
+
+  Ipv4InterfaceContainer Assign(NetDeviceContainer devices, uint32_t subnet) {
+    NS_ABORT_MSG_IF(subnet >= (1u << 16),
+                    "Part3Topology: out of 10.0.0.0/8 subnets");
+    m_addresses.SetBase(SubnetAddress(subnet), "255.255.255.0");
+    return m_addresses.Assign(devices);
+  }
+
+  static uint32_t InterfaceOf(Ptr<NetDevice> device) {
+    return device->GetNode()->GetObject<Ipv4>()->GetInterfaceForDevice(device);
+  }
+
+  static void SetDefaultRoute(Ptr<Node> node, Ptr<NetDevice> device,
+                              Ipv4Address nextHop) {
+    Ipv4StaticRoutingHelper staticRouting;
+    staticRouting.GetStaticRouting(node->GetObject<Ipv4>())
+        ->SetDefaultRoute(nextHop, InterfaceOf(device));
+  }
+
+  std::string m_linkType;
+  std::string m_accessRate, m_coreRate, m_serverRate;
+  std::string m_delay;
+  std::string m_deviceQueue, m_serverDeviceQueue;
+  uint32_t m_ranks;
+
+  PointToPointHelper m_p2p;
+  CsmaHelper m_csma;
+  Ipv4AddressHelper m_addresses;
+
+  NodeContainer m_nodes;
+  Ptr<Node> m_gateway, m_server, m_router;
+  NodeContainer m_routers, m_sources;
+  NetDeviceContainer m_serverDevices;
+  NetDeviceContainer m_routerDevices;
+  Ipv4Address m_serverAddress, m_routerAddress;
+  std::vector<Ipv4Address> m_sourceAddresses;
+};
+
+} // namespace ns3
+
+#endif /* PART3_TOPOLOGY_H */
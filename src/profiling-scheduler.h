@@ -0,0 +1,290 @@
+#ifndef PROFILING_SCHEDULER_H
+#define PROFILING_SCHEDULER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+#include <cxxabi.h>
+
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// Scheduler that profiles the events it hands to the simulator, keeping
+// them in the scheduler named by the Inner attribute. It is only in the
+// event path when selected, so a run without it pays nothing.
+//
+// Events are grouped by handler, i.e. by the dynamic type of their
+// EventImpl: for Simulator::Schedule(&Class::Method, object, ...) that is
+// the member function's class and signature. Every event is counted. The
+// wall-clock cost of one event in SampleEvery is measured, as the time from
+// handing it out to the simulator asking for the next one, and the total
+// per handler is estimated from the sampled mean.
+//
+// The profile is written by a destroy event scheduled along with the first
+// event, so it covers every event the run executed. Simulator::Destroy()
+// runs the destroy events itself, not through the scheduler, and only then
+// disposes of the simulator, which drains the events still pending through
+// RemoveNext(); those never ran and are not counted. The files are:
+//
+//   <Output>.txt       the handlers, most expensive first
+//   <Output>-rate.txt  events and events per second of wall time for each
+//                      Bin of simulated time
+//   <Output>.folded    with Folded, the estimated cost per handler as
+//                      folded stacks for flamegraph.pl, in microseconds
+class ProfilingScheduler : public Scheduler {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::ProfilingScheduler")
+            .SetParent<Scheduler>()
+            .AddConstructor<ProfilingScheduler>()
+            .AddAttribute("Inner", "Scheduler that holds the events",
+                          StringValue("ns3::MapScheduler"),
+                          MakeStringAccessor(&ProfilingScheduler::SetInner),
+                          MakeStringChecker())
+            .AddAttribute("Output", "Prefix of the profile files",
+                          StringValue("profile"),
+                          MakeStringAccessor(&ProfilingScheduler::m_output),
+                          MakeStringChecker())
+            .AddAttribute("Folded", "Also write a flame graph profile",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&ProfilingScheduler::m_folded),
+                          MakeBooleanChecker())
+            .AddAttribute("SampleEvery",
+                          "Measure the wall-clock cost of one event in this "
+                          "many",
+                          UintegerValue(64),
+                          MakeUintegerAccessor(
+                              &ProfilingScheduler::m_sampleEvery),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("Bin", "Simulated time per events/s figure",
+                          TimeValue(Seconds(0.1)),
+                          MakeTimeAccessor(&ProfilingScheduler::m_bin),
+                          MakeTimeChecker());
+    return tid;
+  }
+
+  ProfilingScheduler()
+      : m_folded(false), m_sampleEvery(64), m_started(false),
+        m_finished(false), m_binEnd(0), m_binEvents(0), m_countdown(0),
+        m_lastType(0), m_last(0), m_pending(0) {}
+
+  virtual void Insert(const Event &ev) { m_inner->Insert(ev); }
+  virtual bool IsEmpty() const { return m_inner->IsEmpty(); }
+  virtual Event PeekNext() const { return m_inner->PeekNext(); }
+  virtual void Remove(const Event &ev) { m_inner->Remove(ev); }
+
+  virtual Event RemoveNext() {
+    if (m_finished)
+      return m_inner->RemoveNext();
+    if (m_pending) {
+      m_lastWall = Clock::now();
+      m_pending->wall += WallSeconds(m_lastWall - m_sampleStart);
+      m_pending->sampled++;
+      m_pending = 0;
+    }
+
+    Event ev = m_inner->RemoveNext();
+    if (!m_started) {
+      m_started = true;
+      m_binStart = m_lastWall = Clock::now();
+      m_binEnd = NextBinEnd(ev.key.m_ts);
+      Simulator::ScheduleDestroy(&ProfilingScheduler::Finish, this);
+    }
+    if (ev.key.m_ts >= m_binEnd)
+      CloseBins(ev.key.m_ts);
+    m_binEvents++;
+
+    Handler &handler = Find(typeid(*ev.impl));
+    handler.events++;
+    if (++m_countdown == m_sampleEvery) {
+      m_countdown = 0;
+      m_pending = &handler;
+      m_sampleStart = Clock::now();
+    }
+    return ev;
+  }
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Handler {
+    Handler() : events(0), sampled(0), wall(0) {}
+    uint64_t events;
+    uint64_t sampled;
+    double wall; // seconds over the sampled events
+
+    double GetEstimate() const { return sampled ? wall / sampled * events : 0; }
+  };
+
+  struct Bin {
+    uint64_t end; // time steps
+    uint64_t events;
+    double wall;
+  };
+
+  static double WallSeconds(Clock::duration d) {
+    return std::chrono::duration<double>(d).count();
+  }
+
+  void SetInner(std::string name) {
+    NS_ABORT_MSG_IF(m_inner && !m_inner->IsEmpty(),
+                    "ProfilingScheduler: Inner set while holding events");
+    ObjectFactory factory;
+    factory.SetTypeId(name);
+    m_inner = factory.Create<Scheduler>();
+  }
+
+  Handler &Find(const std::type_info &type) {
+    if (&type != m_lastType) {
+      m_lastType = &type;
+      m_last = &m_handlers[std::type_index(type)];
+    }
+    return *m_last;
+  }
+
+  uint64_t NextBinEnd(uint64_t ts) const {
+    uint64_t width = std::max<int64_t>(m_bin.GetTimeStep(), 1);
+    return (ts / width + 1) * width;
+  }
+
+  // Closes the bins that end at or before ts; the wall time of the whole
+  // stretch goes to the last of them.
+  void CloseBins(uint64_t ts) {
+    Clock::time_point now = Clock::now();
+    while (m_binEnd <= ts) {
+      Bin bin = {m_binEnd, m_binEvents, 0};
+      m_bins.push_back(bin);
+      m_binEvents = 0;
+      m_binEnd = NextBinEnd(m_binEnd);
+    }
+    m_bins.back().wall = WallSeconds(now - m_binStart);
+    m_binStart = m_lastWall = now;
+  }
+
+  // The handler's name: for member and function events the template
+  // arguments of the MakeEvent() that made them, otherwise the type.
+  static std::string Name(const std::type_index &type) {
+    int status;
+    char *demangled = abi::__cxa_demangle(type.name(), 0, 0, &status);
+    std::string name = status == 0 ? demangled : type.name();
+    std::free(demangled);
+
+    std::string::size_type begin = name.find("MakeEvent<");
+    if (begin == std::string::npos)
+      return name;
+    begin += 10;
+    int depth = 1;
+    std::string::size_type end = begin;
+    for (; end < name.size() && depth > 0; end++)
+      depth += name[end] == '<' ? 1 : name[end] == '>' ? -1 : 0;
+    return name.substr(begin, end - 1 - begin);
+  }
+
+  // "void (ns3::Foo::*)(int), ns3::Foo*" -> "ns3::Foo"
+  static std::string ClassOf(std::string name) {
+    std::string::size_type end = name.find("::*)");
+    if (end == std::string::npos)
+      return "functions";
+    std::string::size_type begin = name.rfind('(', end);
+    return name.substr(begin + 1, end - begin - 1);
+  }
+
+  void Finish() {
+    m_finished = true;
+    if (m_binEvents > 0) {
+      Bin bin = {m_binEnd, m_binEvents, WallSeconds(m_lastWall - m_binStart)};
+      m_bins.push_back(bin);
+    }
+
+    std::vector<std::pair<double, std::type_index>> order;
+    uint64_t events = 0;
+    double wall = 0;
+    for (const auto &entry : m_handlers) {
+      order.push_back(std::make_pair(entry.second.GetEstimate(), entry.first));
+      events += entry.second.events;
+    }
+    std::sort(order.begin(), order.end(),
+              [](const std::pair<double, std::type_index> &a,
+                 const std::pair<double, std::type_index> &b) {
+                return a.first > b.first;
+              });
+    for (const Bin &bin : m_bins)
+      wall += bin.wall;
+
+    std::FILE *out = Open(m_output + ".txt");
+    std::fprintf(out, "# %llu events in %.6g s of wall time, %.6g events/s\n",
+                 (unsigned long long)events, wall,
+                 wall > 0 ? events / wall : 0);
+    std::fprintf(out, "# events share sampled mean_us est_seconds handler\n");
+    for (const auto &entry : order) {
+      const Handler &handler = m_handlers[entry.second];
+      std::fprintf(out, "%llu %.4f %llu %.6g %.6g %s\n",
+                   (unsigned long long)handler.events,
+                   (double)handler.events / events,
+                   (unsigned long long)handler.sampled,
+                   handler.sampled ? handler.wall / handler.sampled * 1e6 : 0,
+                   entry.first, Name(entry.second).c_str());
+    }
+    std::fclose(out);
+
+    out = Open(m_output + "-rate.txt");
+    std::fprintf(out, "# sim_time events wall_seconds events_per_second\n");
+    for (const Bin &bin : m_bins) {
+      std::fprintf(out, "%.9g %llu %.6g %.6g\n",
+                   TimeStep(bin.end).GetSeconds(),
+                   (unsigned long long)bin.events, bin.wall,
+                   bin.wall > 0 ? bin.events / bin.wall : 0);
+    }
+    std::fclose(out);
+
+    if (!m_folded)
+      return;
+    out = Open(m_output + ".folded");
+    for (const auto &entry : order) {
+      std::string name = Name(entry.second);
+      std::fprintf(out, "Simulator::Run;%s;%s %llu\n", ClassOf(name).c_str(),
+                   name.c_str(), (unsigned long long)(entry.first * 1e6));
+    }
+    std::fclose(out);
+  }
+
+  static std::FILE *Open(std::string filename) {
+    std::FILE *file = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_IF(!file, "ProfilingScheduler: cannot open " << filename);
+    return file;
+  }
+
+  Ptr<Scheduler> m_inner;
+  std::string m_output;
+  bool m_folded;
+  uint32_t m_sampleEvery;
+  Time m_bin;
+
+  bool m_started, m_finished;
+  std::unordered_map<std::type_index, Handler> m_handlers;
+  std::vector<Bin> m_bins;
+  uint64_t m_binEnd, m_binEvents;
+  Clock::time_point m_binStart, m_lastWall;
+
+  uint32_t m_countdown;
+  const std::type_info *m_lastType;
+  Handler *m_last;
+  Handler *m_pending;
+  Clock::time_point m_sampleStart;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingScheduler);
+
+} // namespace ns3
+
+#endif /* PROFILING_SCHEDULER_H */
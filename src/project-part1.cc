@@ -5,128 +5,35 @@
 #include "ns3/point-to-point-module.h"
 #include "string"
 
+#include "file-writer.h"
+#include "parallel-series.h"
+#include "part1-generators.h"
+
 #include <cmath>
+#include <fstream>
 #include <math.h>
+#include <memory>
 
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("Project");
 
-class File_writer {
-private:
-  std::string filename;
-  std::vector<std::vector<double>> data;
-
-public:
-  void set_filename(std::string filename) { this->filename = filename; }
-
-  void append(std::vector<double> data) { this->data.push_back(data); }
-
-  void write() {
-    std::fstream output;
-    output.open(this->filename + ".csv", std::fstream::out);
-
-    if (output.is_open()) {
-      if (this->data.size() > 0) {
-        for (unsigned int row = 0; row < this->data.size(); row++) {
-          for (unsigned int col = 0; col < this->data[row].size(); col++) {
-            output << this->data[row][col];
-
-            if (col != this->data[row].size() - 1) {
-              output << ", ";
-            }
-          }
-
-          output << "\n";
-        }
-      }
-    }
-  }
-};
-
-std::vector<double> lcg_rand(long a, int c, int m, int seed, int n) {
-  std::vector<double> values;
-
-  for (int i = 0; i < n; i++) {
-    double max = 1.0 / (1.0 + (m - 1));
-    seed = (int)(a * seed + c) % (int)m;
-
-    if (seed < 0)
-      seed += m;
-
-    values.push_back((double)seed * max);
-  }
-
-  return values;
-}
-
-std::vector<double> poisson(std::vector<double> U, double lambda, int length) {
-  for (int i = 0; i < length; i++) {
-    U[i] = -((std::log(U[i])) / lambda);
-  }
-
-  return U;
-}
-
-std::vector<double> ns3_urv(double min, double max, int n) {
-  std::vector<double> data;
-
-  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable>();
-  x->SetAttribute("Min", DoubleValue(min));
-  x->SetAttribute("Max", DoubleValue(max));
-
-  for (int i = 0; i < n; i++) {
-    data.push_back(x->GetValue());
-  }
-
-  return data;
-}
-
-std::vector<double> ns3_rvn(double mean, double bound, int n) {
-  std::vector<double> data;
-
-  Ptr<ExponentialRandomVariable> x = CreateObject<ExponentialRandomVariable>();
-  x->SetAttribute("Mean", DoubleValue(mean));
-  x->SetAttribute("Bound", DoubleValue(bound));
-
-  for (int i = 0; i < n; i++) {
-    data.push_back(x->GetValue());
-  }
-
-  return data;
-}
-
-std::vector<double> prob_func(int n) {
-  std::vector<double> data;
-  int pdf = 0;
-  for (int i = 0; i < n; i++) {
-    pdf = rand() % 200;
-    if (pdf > 360)
-      std::cout << 1 << " ";
-    else if (pdf < 0)
-      std::cout << 0 << " ";
-    else
-      data.push_back(pdf * 0.1 / 360);
-  }
-
-  return data;
-}
-
 int main(int argc, char *argv[]) {
-  double min = 0.0, max = 1.0, lambda = 3.14, bound = 1.0;
-  int a = 13, c = 1, m = 100, seed = 1, n = 1000;
+  Series_params p;
+  int n = 1000, threads = 0;
   bool lcg = false, ns3 = false, all = false, poi = false, rvn = false,
-       pdf = false, write_to_file = true;
+       pdf = false, write_to_file = true, gof = false;
+  std::string format = "csv";
 
   CommandLine cmd;
-  cmd.AddValue("min", "", min);
-  cmd.AddValue("max", "", max);
-  cmd.AddValue("lambda", "", lambda);
-  cmd.AddValue("bound", "", bound);
-  cmd.AddValue("m", "", m);
-  cmd.AddValue("a", "", a);
-  cmd.AddValue("c", "", c);
-  cmd.AddValue("seed", "", seed);
+  cmd.AddValue("min", "", p.min);
+  cmd.AddValue("max", "", p.max);
+  cmd.AddValue("lambda", "", p.lambda);
+  cmd.AddValue("bound", "", p.bound);
+  cmd.AddValue("m", "", p.m);
+  cmd.AddValue("a", "", p.a);
+  cmd.AddValue("c", "", p.c);
+  cmd.AddValue("seed", "", p.seed);
   cmd.AddValue("n", "", n);
 
   cmd.AddValue("lcg", "", lcg);
@@ -135,34 +42,91 @@ int main(int argc, char *argv[]) {
   cmd.AddValue("rvn", "", rvn);
   cmd.AddValue("pdf", "", pdf);
   cmd.AddValue("all", "", all);
+  cmd.AddValue("pmf",
+               "PMF (value weight) or histogram (lo hi weight) file for -pdf",
+               p.pmf);
+  cmd.AddValue("exact_log", "Use std::log instead of the fast log in -poi",
+               p.exact_log);
+
+  cmd.AddValue("threads",
+               "Worker threads; 0 keeps the single-threaded generators",
+               threads);
+
+  cmd.AddValue("gof", "Write goodness-of-fit statistics for each series",
+               gof);
+  cmd.AddValue("write", "Write the series to a file", write_to_file);
+  cmd.AddValue("format", "Output format: csv or bin", format);
 
   cmd.Parse(argc, argv);
 
+  NS_ABORT_MSG_IF(format != "csv" && format != "bin",
+                  "unknown -format " << format);
+
   File_writer fw;
-  // fw.set_filename("m" + std::to_string(m) + "-c" + std::to_string(c) + "-a" +
-  // std::to_string(a));
-  fw.set_filename("poirvn-m" + std::to_string(m) + "-c" + std::to_string(c) +
-                  "-a" + std::to_string(a));
+  // fw.set_filename("m" + std::to_string(p.m) + "-c" + std::to_string(p.c) +
+  // "-a" + std::to_string(p.a));
+  std::string filename = "poirvn-m" + std::to_string(p.m) + "-c" +
+                         std::to_string(p.c) + "-a" + std::to_string(p.a);
+  fw.set_filename(filename);
+  if (!write_to_file)
+    fw.set_format(File_writer::NONE);
+  else if (format == "bin")
+    fw.set_format(File_writer::BINARY);
 
   if (all)
     lcg = ns3 = rvn = poi = pdf = true;
 
+  std::vector<std::string> series;
   if (lcg)
-    fw.append(lcg_rand(a, c, m, seed, n));
-
+    series.push_back("lcg");
   if (ns3)
-    fw.append(ns3_urv(min, max, n));
-
+    series.push_back("ns3");
   if (poi)
-    fw.append(poisson(lcg_rand(a, c, m, seed, n), lambda, n));
-
+    series.push_back("poi");
   if (rvn)
-    fw.append(ns3_rvn(lambda, bound, n));
+    series.push_back("rvn");
   if (pdf)
-    fw.append(prob_func(n));
+    series.push_back("pdf");
+
+  std::ofstream report;
+  if (gof) {
+    report.open(filename + ".gof.txt");
+    report << Gof_stream::header() << "\n";
+  }
+
+  for (const std::string &name : series) {
+    std::unique_ptr<Parallel_series> parallel;
+    std::function<void(double *, int)> fill;
+    int chunk_size = 1 << 16;
+
+    if (threads > 0) {
+      parallel.reset(new Parallel_series(name, p, threads));
+      Parallel_series *gen = parallel.get();
+      fill = [gen](double *out, int k) { gen->fill(out, k); };
+      chunk_size = gen->window();
+    } else {
+      fill = make_series(name, p);
+    }
+
+    // The statistics see the samples chunk by chunk as they are written.
+    std::unique_ptr<Gof_stream> check;
+    if (gof && name != "pdf") {
+      check.reset(new Gof_stream(series_target(name, p)));
+      Gof_stream *stats = check.get();
+      std::function<void(double *, int)> generate = fill;
+      fill = [generate, stats](double *out, int k) {
+        generate(out, k);
+        stats->add(out, k);
+      };
+    }
+
+    stream_series(fw, name, n, fill, chunk_size);
+
+    if (check)
+      report << check->line(name) << "\n";
+  }
 
-  if (write_to_file)
-    fw.write();
+  fw.write();
 
   return 0;
 }
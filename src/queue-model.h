@@ -0,0 +1,146 @@
+#ifndef QUEUE_MODEL_H
+#define QUEUE_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+// First two moments of a packet's transmission time, in seconds and
+// seconds squared.
+struct ServiceTime {
+  ServiceTime() : mean(0), secondMoment(0) {}
+  ServiceTime(double m, double m2) : mean(m), secondMoment(m2) {}
+
+  // Frames of overhead + max(minPayload, X) bytes, padded to minFrame, with
+  // X exponential of mean meanPayload, sent at bitRate.
+  static ServiceTime Exponential(double meanPayload, double minPayload,
+                                 double overhead, double minFrame,
+                                 double bitRate) {
+    // The frame is base + Y, with Y exponential past the floor and 0 below.
+    double floor = std::max(minPayload, minFrame - overhead);
+    double base = overhead + floor;
+    double tail = meanPayload > 0 ? std::exp(-floor / meanPayload) : 0;
+    double bytes = base + tail * meanPayload;
+    double bytes2 = base * base + 2 * base * tail * meanPayload +
+                    2 * tail * meanPayload * meanPayload;
+    double scale = 8 / bitRate;
+    return ServiceTime(scale * bytes, scale * scale * bytes2);
+  }
+
+  // Frames of a fixed size.
+  static ServiceTime Fixed(double frameBytes, double bitRate) {
+    double time = 8 * frameBytes / bitRate;
+    return ServiceTime(time, time * time);
+  }
+
+  double mean;
+  double secondMoment;
+};
+
+// A Poisson stream of packets into a queue.
+struct Traffic {
+  Traffic(double r, ServiceTime s) : rate(r), service(s) {}
+  double rate; // packets per second
+  ServiceTime service;
+};
+
+struct QueueEstimate {
+  std::string name;
+  double arrivalRate;      // packets per second offered
+  double utilisation;      // of the transmitter, shared traffic included
+  double meanWait;         // before transmission, seconds
+  double meanDelay;        // wait plus transmission, seconds
+  double meanPackets;      // waiting and in transmission
+  double loss;             // fraction of the arrivals dropped
+  double throughput;       // packets per second passed on
+  double queueDiscPackets; // mean held in the queue disc
+  double queueDiscDelay;   // mean per packet passed on, seconds
+};
+
+// P(more than n packets) in M/M/1/K at the given utilisation, with K = room.
+inline double QueueTail(double load, uint32_t room, uint32_t n) {
+  if (n >= room)
+    return 0;
+  if (load == 1)
+    return (double)(room - n) / (room + 1);
+  if (load < 1)
+    return (std::pow(load, n + 1) - std::pow(load, room + 1)) /
+           (1 - std::pow(load, room + 1));
+  // The same with 1 / load, counted from K down, so nothing overflows.
+  double s = 1 / load;
+  return (1 - std::pow(s, room - n)) / (1 - std::pow(s, room + 1));
+}
+
+// Estimates for a transmit queue fed by Poisson arrivals: a queue disc of
+// queueDisc packets in front of a device queue of deviceQueue packets in
+// front of the transmitter. shared is traffic that takes the transmitter
+// but is not in this queue, i.e. the other side of a half-duplex link.
+//
+// The wait is the Pollaczek-Khinchine M/G/1 mean, which needs only the two
+// moments of the transmission time and so is exact for any size
+// distribution and mix of packet types, but assumes the buffer never fills
+// and is infinite at saturation. The loss and the queue disc's share of the
+// backlog come from M/M/1/K at the same utilisation, with K the whole room
+// (queue disc, device queue and the packet in transmission): approximate
+// for non-exponential sizes, but defined at and beyond saturation.
+inline QueueEstimate EstimateQueue(std::string name,
+                                   const std::vector<Traffic> &own,
+                                   const std::vector<Traffic> &shared,
+                                   uint32_t deviceQueue, uint32_t queueDisc) {
+  double ownRate = 0, ownWork = 0;
+  for (const Traffic &t : own) {
+    ownRate += t.rate;
+    ownWork += t.rate * t.service.mean;
+  }
+  std::vector<Traffic> all(own);
+  all.insert(all.end(), shared.begin(), shared.end());
+  double rate = 0, load = 0, second = 0;
+  for (const Traffic &t : all) {
+    rate += t.rate;
+    load += t.rate * t.service.mean;
+    second += t.rate * t.service.secondMoment;
+  }
+
+  const double infinity = std::numeric_limits<double>::infinity();
+  QueueEstimate e;
+  e.name = name;
+  e.arrivalRate = ownRate;
+  e.utilisation = load;
+  e.meanWait = load < 1 ? second / (2 * (1 - load)) : infinity;
+  e.meanDelay = e.meanWait + (ownRate > 0 ? ownWork / ownRate : 0);
+  e.meanPackets = ownRate > 0 ? ownRate * e.meanDelay : 0;
+
+  // M/M/1/K: P(n) is proportional to load^n for n = 0..K. The terms are
+  // summed from the likely end, 0 below saturation and K above, until they
+  // no longer matter.
+  uint32_t room = queueDisc + deviceQueue + 1;
+  uint32_t held = deviceQueue + 1; // beyond this the queue disc holds packets
+  double sum = 0, full = 0, inQueueDisc = 0, w = 1;
+  for (uint32_t k = 0; k <= room; k++) {
+    uint32_t n = load <= 1 ? k : room - k;
+    sum += w;
+    if (n == room)
+      full = w;
+    if (n > held)
+      inQueueDisc += (n - held) * w;
+    if (w < 1e-17 * sum)
+      break;
+    w = load <= 1 ? w * load : w / load;
+  }
+  double share = rate > 0 ? ownRate / rate : 0;
+  e.loss = full / sum;
+  e.throughput = ownRate * (1 - e.loss);
+  e.queueDiscPackets = share * inQueueDisc / sum;
+  e.queueDiscDelay =
+      e.throughput > 0 ? e.queueDiscPackets / e.throughput : 0;
+  return e;
+}
+
+} // namespace ns3
+
+#endif /* QUEUE_MODEL_H */
@@ -0,0 +1,357 @@
+#ifndef QUEUE_MONITOR_H
+#define QUEUE_MONITOR_H
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "quantile-sketch.h"
+#include "queue-trace.h"
+
+namespace ns3 {
+
+// Records the occupancy of queue discs and device queues, one file per
+// watched queue: <prefix>_<label>.txt with "time\tsize" lines, or, when
+// binary, <prefix>_<label>.qtr written through a QueueTraceWriter (see
+// queue-trace.h and queue-trace-to-text.cc).
+//
+// By default it connects to the PacketsInQueue trace source of each queue
+// and writes a line only when the occupancy changes. Nothing is scheduled,
+// and the cost follows the traffic rather than the run length.
+//
+// EnableSampling() records every watched queue at a fixed interval instead,
+// like the old pre-scheduled TcPacketsInQueue loop, but from one event that
+// reschedules itself. Sample k is taken at start + k * interval, computed in
+// integer Time, so the grid does not drift.
+//
+// Either way the monitor keeps running statistics of each queue's
+// occupancy, counted from the first packet that reaches it: the
+// time-weighted mean and variance, the maximum and the time spent at each
+// occupancy, which gives exact time-weighted quantiles. For queue discs,
+// WatchSojournTime() adds a QuantileSketch of the sojourn times. With an
+// empty prefix only the statistics are kept and no files are written.
+class QueueMonitor {
+public:
+  QueueMonitor(std::string prefix, bool binary = false)
+      : m_prefix(prefix), m_binary(binary), m_sampling(false) {}
+
+  // The queues hold the trace callbacks and the watches hold the queues.
+  // Disconnecting breaks that cycle, so the files get flushed and closed.
+  ~QueueMonitor() {
+    for (Ptr<Watch> watch : m_watches) {
+      if (watch->qdisc)
+        watch->qdisc->TraceDisconnectWithoutContext(
+            "PacketsInQueue", MakeCallback(&Watch::Changed, watch));
+      else
+        watch->queue->TraceDisconnectWithoutContext(
+            "PacketsInQueue", MakeCallback(&Watch::Changed, watch));
+      if (watch->sojourn)
+        watch->qdisc->TraceDisconnectWithoutContext(
+            "SojournTime", MakeCallback(&Watch::Sojourn, watch));
+      if (watch->writer)
+        watch->writer->Flush();
+    }
+  }
+
+  void WatchQueueDisc(std::string label, Ptr<QueueDisc> qdisc) {
+    Ptr<Watch> watch = Add(label);
+    watch->qdisc = qdisc;
+    qdisc->TraceConnectWithoutContext("PacketsInQueue",
+                                      MakeCallback(&Watch::Changed, watch));
+  }
+
+  // The device's transmit queue, e.g. of a PointToPointNetDevice or a
+  // CsmaNetDevice; both expose it as the TxQueue attribute.
+  void WatchDeviceQueue(std::string label, Ptr<NetDevice> device) {
+    Ptr<QueueBase> queue = GetTxQueue(device);
+    NS_ABORT_MSG_IF(!queue, "QueueMonitor: device has no TxQueue");
+
+    Ptr<Watch> watch = Add(label);
+    watch->queue = queue;
+    queue->TraceConnectWithoutContext("PacketsInQueue",
+                                      MakeCallback(&Watch::Changed, watch));
+  }
+
+  // Every root queue disc on the given nodes that is not watched yet,
+  // labelled qdisc-<node>-<device>.
+  void WatchAllQueueDiscs(NodeContainer nodes) {
+    for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+      Ptr<Node> node = nodes.Get(i);
+      Ptr<TrafficControlLayer> tc = node->GetObject<TrafficControlLayer>();
+      if (!tc)
+        continue;
+      for (uint32_t d = 0; d < node->GetNDevices(); ++d) {
+        Ptr<QueueDisc> qdisc =
+            tc->GetRootQueueDiscOnDevice(node->GetDevice(d));
+        if (qdisc && !IsWatched(qdisc, 0))
+          WatchQueueDisc(Label("qdisc", node, d), qdisc);
+      }
+    }
+  }
+
+  // Likewise for device queues, labelled dev-<node>-<device>.
+  void WatchAllDeviceQueues(NodeContainer nodes) {
+    for (uint32_t i = 0; i < nodes.GetN(); ++i) {
+      Ptr<Node> node = nodes.Get(i);
+      for (uint32_t d = 0; d < node->GetNDevices(); ++d) {
+        Ptr<QueueBase> queue = GetTxQueue(node->GetDevice(d));
+        if (queue && !IsWatched(0, queue))
+          WatchDeviceQueue(Label("dev", node, d), node->GetDevice(d));
+      }
+    }
+  }
+
+  // Also sketches the sojourn times of a watched queue disc.
+  void WatchSojournTime(std::string label) {
+    Ptr<Watch> watch = Find(label);
+    NS_ABORT_MSG_IF(!watch->qdisc,
+                    "QueueMonitor: sojourn times need a queue disc");
+    if (watch->sojourn)
+      return;
+    watch->sojourn = true;
+    watch->qdisc->TraceConnectWithoutContext(
+        "SojournTime", MakeCallback(&Watch::Sojourn, watch));
+  }
+
+  // Time-weighted mean occupancy in packets since the first arrival.
+  double GetMeanPackets(std::string label) const {
+    Ptr<Watch> watch = Find(label);
+    double span = watch->GetSpan();
+    return span > 0 ? watch->GetArea(1) / span : 0;
+  }
+
+  // The integral of the occupancy since the first arrival, in
+  // packet-seconds; differences give the mean over an interval.
+  double GetPacketSeconds(std::string label) const {
+    Ptr<Watch> watch = Find(label);
+    return watch->active ? watch->GetArea(1) : 0;
+  }
+
+  double GetVariancePackets(std::string label) const {
+    Ptr<Watch> watch = Find(label);
+    double span = watch->GetSpan();
+    if (span <= 0)
+      return 0;
+    double mean = watch->GetArea(1) / span;
+    return std::max(watch->GetArea(2) / span - mean * mean, 0.0);
+  }
+
+  uint32_t GetMaxPackets(std::string label) const {
+    return Find(label)->max;
+  }
+
+  // Seconds spent at 0, 1, 2, ... packets.
+  std::vector<double> GetHistogram(std::string label) const {
+    Ptr<Watch> watch = Find(label);
+    std::vector<double> histogram = watch->histogram;
+    if (watch->active) {
+      histogram.resize(std::max<std::size_t>(histogram.size(),
+                                             watch->size + 1));
+      histogram[watch->size] +=
+          (Simulator::Now() - watch->last).GetSeconds();
+    }
+    return histogram;
+  }
+
+  // The occupancy the queue was at or below for a fraction q of the time.
+  uint32_t GetPacketsQuantile(std::string label, double q) const {
+    std::vector<double> histogram = GetHistogram(label);
+    double total = 0;
+    for (double seconds : histogram)
+      total += seconds;
+    double seen = 0;
+    for (std::size_t n = 0; n < histogram.size(); n++) {
+      seen += histogram[n];
+      if (seen >= q * total)
+        return n;
+    }
+    return 0;
+  }
+
+  // "packets\tseconds\tfraction" lines.
+  void WriteHistogram(std::string label, std::string filename) const {
+    std::vector<double> histogram = GetHistogram(label);
+    double total = 0;
+    for (double seconds : histogram)
+      total += seconds;
+    std::FILE *file = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_IF(!file, "QueueMonitor: cannot open " << filename);
+    for (std::size_t n = 0; n < histogram.size(); n++)
+      std::fprintf(file, "%u\t%.9g\t%.9g\n", (unsigned)n, histogram[n],
+                   total > 0 ? histogram[n] / total : 0);
+    std::fclose(file);
+  }
+
+  // Sojourn time statistics in seconds, see WatchSojournTime().
+  double GetMeanSojourn(std::string label) const {
+    return Find(label)->sojourns.GetMean();
+  }
+
+  double GetSojournQuantile(std::string label, double q) const {
+    return Find(label)->sojourns.GetQuantile(q);
+  }
+
+  uint64_t GetSojournCount(std::string label) const {
+    return Find(label)->sojourns.GetCount();
+  }
+
+  double GetSojournSum(std::string label) const {
+    return Find(label)->sojourns.GetSum();
+  }
+
+  // Samples all watched queues at start, start + interval, ... while the
+  // sample time is before stop, and stops recording changes.
+  void EnableSampling(Time start, Time interval, Time stop) {
+    NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(),
+                    "QueueMonitor: sampling interval must be positive");
+    m_sampling = true;
+    m_start = start;
+    m_interval = interval;
+    m_stop = stop;
+    if (start < stop)
+      Simulator::Schedule(start - Simulator::Now(), &QueueMonitor::Sample,
+                          this, 0);
+  }
+
+private:
+  struct Watch : public SimpleRefCount<Watch> {
+    std::string label;
+    Ptr<OutputStreamWrapper> stream;
+    Ptr<QueueTraceWriter> writer;
+    Ptr<QueueDisc> qdisc;
+    Ptr<QueueBase> queue;
+    const bool *sampling;
+
+    bool active;
+    Time first, last;
+    uint32_t size, max;
+    double area, area2;            // packet-seconds, packet^2-seconds
+    std::vector<double> histogram; // seconds at each size, up to last
+
+    bool sojourn;
+    QuantileSketch sojourns;
+
+    double GetSpan() const {
+      return active ? (Simulator::Now() - first).GetSeconds() : 0;
+    }
+
+    // The integral of size^power since the first arrival.
+    double GetArea(int power) const {
+      double pending = (Simulator::Now() - last).GetSeconds();
+      return power == 1 ? area + pending * size
+                        : area2 + pending * size * (double)size;
+    }
+
+    uint32_t GetNPackets() const {
+      return qdisc ? qdisc->GetNPackets() : queue->GetNPackets();
+    }
+
+    void Write(uint32_t size) {
+      if (!writer && !stream)
+        return;
+      if (writer)
+        writer->Append(Simulator::Now(), size);
+      else
+        *stream->GetStream() << Simulator::Now().GetSeconds() << "\t" << size
+                             << "\n";
+    }
+
+    void Changed(uint32_t oldValue, uint32_t newValue) {
+      Time now = Simulator::Now();
+      if (!active) {
+        active = true;
+        first = last = now;
+      }
+      double elapsed = (now - last).GetSeconds();
+      area += elapsed * size;
+      area2 += elapsed * size * (double)size;
+      if (size >= histogram.size())
+        histogram.resize(size + 1);
+      histogram[size] += elapsed;
+      last = now;
+      size = newValue;
+      max = std::max(max, newValue);
+
+      if (!*sampling)
+        Write(newValue);
+    }
+
+    void Sojourn(Time sojourn) { sojourns.Add(sojourn.GetSeconds()); }
+  };
+
+  static Ptr<QueueBase> GetTxQueue(Ptr<NetDevice> device) {
+    PointerValue queue;
+    if (!device->GetAttributeFailSafe("TxQueue", queue))
+      return 0;
+    return queue.Get<QueueBase>();
+  }
+
+  Ptr<Watch> Find(std::string label) const {
+    for (Ptr<Watch> watch : m_watches)
+      if (watch->label == label)
+        return watch;
+    NS_ABORT_MSG("QueueMonitor: no queue labelled " << label);
+    return 0;
+  }
+
+  bool IsWatched(Ptr<QueueDisc> qdisc, Ptr<QueueBase> queue) const {
+    for (Ptr<Watch> watch : m_watches)
+      if ((qdisc && watch->qdisc == qdisc) ||
+          (queue && watch->queue == queue))
+        return true;
+    return false;
+  }
+
+  static std::string Label(std::string kind, Ptr<Node> node, uint32_t device) {
+    return kind + "-" + std::to_string(node->GetId()) + "-" +
+           std::to_string(device);
+  }
+
+  Ptr<Watch> Add(std::string label) {
+    Ptr<Watch> watch = Create<Watch>();
+    watch->label = label;
+    watch->active = false;
+    watch->size = watch->max = 0;
+    watch->area = watch->area2 = 0;
+    watch->sojourn = false;
+    if (!m_prefix.empty() && m_binary) {
+      watch->writer =
+          Create<QueueTraceWriter>(m_prefix + "_" + label + ".qtr");
+    } else if (!m_prefix.empty()) {
+      AsciiTraceHelper ascii;
+      watch->stream = ascii.CreateFileStream(m_prefix + "_" + label + ".txt");
+      // Changes land on nanosecond times; the default 6 digits would merge
+      // them.
+      *watch->stream->GetStream() << std::setprecision(12);
+    }
+    watch->sampling = &m_sampling;
+    m_watches.push_back(watch);
+    return watch;
+  }
+
+  void Sample(uint64_t k) {
+    for (Ptr<Watch> watch : m_watches)
+      watch->Write(watch->GetNPackets());
+
+    Time next = m_start + m_interval * (int64_t)(k + 1);
+    if (next < m_stop)
+      Simulator::Schedule(next - Simulator::Now(), &QueueMonitor::Sample, this,
+                          k + 1);
+  }
+
+  std::string m_prefix;
+  bool m_binary;
+  std::vector<Ptr<Watch>> m_watches;
+  bool m_sampling;
+  Time m_start, m_interval, m_stop;
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_MONITOR_H */
@@ -0,0 +1,53 @@
+#include "ns3/core-module.h"
+
+#include "queue-trace.h"
+
+#include <fstream>
+#include <iomanip>
+
+// Converts a binary queue trace (QueueMonitor with binary output, see
+// queue-trace.h) to the "time\tsize" text the text monitor writes, e.g. for
+// part3_plot.m:
+//
+//   ./waf --run "queue-trace-to-text --input=p2p_queue_gs.qtr"
+//
+// writes p2p_queue_gs.txt next to the input unless --output is given.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("QueueTraceToText");
+
+int main(int argc, char *argv[]) {
+  std::string input;
+  std::string output;
+
+  CommandLine cmd;
+  cmd.AddValue("input", "Binary queue trace (.qtr)", input);
+  cmd.AddValue("output", "Text file, defaults to the input with .txt",
+               output);
+  cmd.Parse(argc, argv);
+
+  NS_ABORT_MSG_IF(input.empty(), "queue-trace-to-text: --input is required");
+  if (output.empty()) {
+    std::string::size_type dot = input.rfind('.');
+    output = (dot == std::string::npos ? input : input.substr(0, dot)) + ".txt";
+  }
+
+  QueueTraceReader reader(input);
+  std::ofstream out(output);
+  NS_ABORT_MSG_IF(!out.is_open(),
+                  "queue-trace-to-text: cannot open " << output);
+  out << std::setprecision(12);
+
+  std::vector<int64_t> times;
+  std::vector<uint32_t> values;
+  uint64_t samples = 0;
+  while (reader.ReadBlock(times, values)) {
+    for (std::size_t i = 0; i < times.size(); i++)
+      out << NanoSeconds(times[i]).GetSeconds() << "\t" << values[i] << "\n";
+    samples += times.size();
+  }
+
+  std::cout << samples << " samples written to " << output << std::endl;
+  return 0;
+}
@@ -0,0 +1,172 @@
+#ifndef QUEUE_TRACE_H
+#define QUEUE_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+// Compact binary storage for (time, value) series such as queue occupancy.
+//
+// Samples are collected in a preallocated buffer of BLOCK_SAMPLES entries.
+// When it is full it is encoded and written with a single fwrite, so a
+// sample costs a few stores rather than a formatted, flushed text line.
+//
+// File layout, little endian:
+//
+//   "QTRC" | u32 version
+//   blocks: u32 sample count | u32 payload bytes | payload
+//
+// Each block decodes on its own: the payload is, per sample, two zigzag
+// varints, the change in time step (nanoseconds) relative to the previous
+// sample's step, then the change in value. Both start from zero at the
+// beginning of a block. On a regular sampling grid the time field is a
+// single zero byte, and so is the value field while the queue holds still.
+class QueueTraceWriter : public SimpleRefCount<QueueTraceWriter> {
+public:
+  static const uint32_t VERSION = 1;
+  static const uint32_t BLOCK_SAMPLES = 1 << 16;
+
+  QueueTraceWriter(std::string filename) : m_count(0) {
+    m_file = std::fopen(filename.c_str(), "wb");
+    NS_ABORT_MSG_IF(!m_file, "QueueTraceWriter: cannot open " << filename);
+    uint32_t samples = BLOCK_SAMPLES;
+    m_times.resize(samples);
+    m_values.resize(samples);
+    // Worst case: two 10-byte varints per sample.
+    m_payload.resize(20 * samples);
+
+    uint32_t version = VERSION;
+    std::fwrite("QTRC", 1, 4, m_file);
+    std::fwrite(&version, sizeof(version), 1, m_file);
+  }
+
+  ~QueueTraceWriter() {
+    Flush();
+    std::fclose(m_file);
+  }
+
+  void Append(Time time, uint32_t value) {
+    m_times[m_count] = time.GetNanoSeconds();
+    m_values[m_count] = value;
+    if (++m_count == BLOCK_SAMPLES)
+      Flush();
+  }
+
+  void Flush() {
+    if (m_count == 0)
+      return;
+
+    uint8_t *out = m_payload.data();
+    int64_t time = 0, step = 0, value = 0;
+    for (uint32_t i = 0; i < m_count; i++) {
+      int64_t nextStep = m_times[i] - time;
+      out = PutVarint(out, ZigZag(nextStep - step));
+      out = PutVarint(out, ZigZag((int64_t)m_values[i] - value));
+      time = m_times[i];
+      step = nextStep;
+      value = m_values[i];
+    }
+
+    uint32_t header[2] = {m_count, (uint32_t)(out - m_payload.data())};
+    std::fwrite(header, sizeof(header), 1, m_file);
+    std::fwrite(m_payload.data(), 1, header[1], m_file);
+    m_count = 0;
+  }
+
+private:
+  static uint64_t ZigZag(int64_t v) {
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+  }
+
+  static uint8_t *PutVarint(uint8_t *out, uint64_t v) {
+    while (v >= 0x80) {
+      *out++ = (uint8_t)(v | 0x80);
+      v >>= 7;
+    }
+    *out++ = (uint8_t)v;
+    return out;
+  }
+
+  std::FILE *m_file;
+  std::vector<int64_t> m_times;
+  std::vector<uint32_t> m_values;
+  std::vector<uint8_t> m_payload;
+  uint32_t m_count;
+};
+
+// Reads files written by QueueTraceWriter one block at a time.
+class QueueTraceReader {
+public:
+  QueueTraceReader(std::string filename) {
+    m_file = std::fopen(filename.c_str(), "rb");
+    NS_ABORT_MSG_IF(!m_file, "QueueTraceReader: cannot open " << filename);
+
+    char magic[4];
+    uint32_t version = 0;
+    bool ok = std::fread(magic, 1, 4, m_file) == 4 &&
+              std::fread(&version, sizeof(version), 1, m_file) == 1;
+    NS_ABORT_MSG_IF(!ok || std::string(magic, 4) != "QTRC",
+                    "QueueTraceReader: " << filename
+                                         << " is not a queue trace");
+    NS_ABORT_MSG_IF(version != QueueTraceWriter::VERSION,
+                    "QueueTraceReader: unsupported version " << version);
+  }
+
+  ~QueueTraceReader() { std::fclose(m_file); }
+
+  // Replaces times (nanoseconds) and values with the next block. Returns
+  // false at the end of the file.
+  bool ReadBlock(std::vector<int64_t> &times, std::vector<uint32_t> &values) {
+    uint32_t header[2];
+    if (std::fread(header, sizeof(header), 1, m_file) != 1)
+      return false;
+
+    m_payload.resize(header[1]);
+    NS_ABORT_MSG_IF(std::fread(m_payload.data(), 1, header[1], m_file) !=
+                        header[1],
+                    "QueueTraceReader: truncated block");
+
+    times.resize(header[0]);
+    values.resize(header[0]);
+    const uint8_t *in = m_payload.data();
+    const uint8_t *end = in + m_payload.size();
+    int64_t time = 0, step = 0, value = 0;
+    for (uint32_t i = 0; i < header[0]; i++) {
+      step += UnZigZag(GetVarint(in, end));
+      time += step;
+      value += UnZigZag(GetVarint(in, end));
+      times[i] = time;
+      values[i] = (uint32_t)value;
+    }
+    return true;
+  }
+
+private:
+  static int64_t UnZigZag(uint64_t v) {
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+  }
+
+  static uint64_t GetVarint(const uint8_t *&in, const uint8_t *end) {
+    uint64_t v = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+      uint8_t byte = *in++;
+      v |= (uint64_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return v;
+    }
+    NS_ABORT_MSG("QueueTraceReader: corrupt varint");
+    return v;
+  }
+
+  std::FILE *m_file;
+  std::vector<uint8_t> m_payload;
+};
+
+} // namespace ns3
+
+#endif /* QUEUE_TRACE_H */
@@ -0,0 +1,51 @@
+#ifndef RUN_SUMMARY_H
+#define RUN_SUMMARY_H
+
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+#include "flow-tally.h"
+
+namespace ns3 {
+
+// The scalar results of one run as "key value" lines, in the order they were
+// set. part3-sweep reads these files back to aggregate replications.
+class RunSummary {
+public:
+  void Set(std::string key, double value) {
+    for (std::pair<std::string, double> &entry : m_values) {
+      if (entry.first == key) {
+        entry.second = value;
+        return;
+      }
+    }
+    m_values.push_back(std::make_pair(key, value));
+  }
+
+  // End-to-end delay and loss over all packets the tally has seen.
+  void SetFlowStats(const FlowTally::Totals &flows) {
+    double delaySum = TimeStep(flows.delaySum).GetSeconds();
+    Set("delay_mean", flows.rxPackets ? delaySum / flows.rxPackets : 0);
+    Set("rx_packets", flows.rxPackets);
+    Set("lost_packets", flows.lostPackets);
+  }
+
+  void Write(std::string filename) const {
+    std::FILE *file = std::fopen(filename.c_str(), "w");
+    NS_ABORT_MSG_IF(!file, "RunSummary: cannot open " << filename);
+    for (const std::pair<std::string, double> &entry : m_values)
+      std::fprintf(file, "%s %.17g\n", entry.first.c_str(), entry.second);
+    std::fclose(file);
+  }
+
+private:
+  std::vector<std::pair<std::string, double>> m_values;
+};
+
+} // namespace ns3
+
+#endif /* RUN_SUMMARY_H */
@@ -0,0 +1,140 @@
+#ifndef SAMPLED_PCAP_H
+#define SAMPLED_PCAP_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+namespace ns3 {
+
+// A pcap capture of one device that is cheap enough to leave on for a long
+// run, unlike EnablePcapAll(), which formats and flushes every packet of
+// every device.
+//
+// Only the packets between start and stop are seen: the device's Sniffer
+// trace, everything it sends and receives with the link header, is
+// connected at start and disconnected at stop, so outside the window the
+// capture costs nothing. Of those, a fraction sampling is kept, every
+// 1 / sampling-th packet rather than a random choice, so the capture takes
+// nothing from the run's random streams and the same run captures the same
+// packets. Of each, only the first snapLen bytes are copied out of the
+// packet, enough for the link, IP and UDP headers at the default of 64.
+//
+// Records go into a 1 MiB buffer that is written out with one fwrite when
+// it is full. The file is classic pcap with nanosecond timestamps, magic
+// 0xa1b23c4d, which tcpdump and Wireshark read; the link type is PPP for
+// point-to-point devices and Ethernet for CSMA, as with EnablePcap().
+class SampledPcap : public SimpleRefCount<SampledPcap> {
+public:
+  SampledPcap(Ptr<NetDevice> device, std::string filename, double sampling,
+              uint32_t snapLen, Time start, Time stop)
+      : m_device(device), m_sampling(sampling), m_snapLen(snapLen),
+        m_credit(1), m_used(0), m_seen(0), m_captured(0) {
+    NS_ABORT_MSG_IF(sampling <= 0 || sampling > 1,
+                    "SampledPcap: sampling must be in (0, 1]");
+    NS_ABORT_MSG_IF(snapLen == 0 || snapLen > 65535,
+                    "SampledPcap: snapLen must be in 1..65535");
+    uint32_t linkType = 0;
+    if (DynamicCast<PointToPointNetDevice>(device))
+      linkType = 9; // DLT_PPP
+    else if (DynamicCast<CsmaNetDevice>(device))
+      linkType = 1; // DLT_EN10MB
+    NS_ABORT_MSG_IF(!linkType, "SampledPcap: unsupported device type");
+
+    m_file = std::fopen(filename.c_str(), "wb");
+    NS_ABORT_MSG_IF(!m_file, "SampledPcap: cannot open " << filename);
+    m_buffer.resize(1 << 20);
+    m_record.resize(snapLen);
+
+    // magic, version 2.4, GMT offset, accuracy, snap length, link type
+    uint32_t magic = 0xa1b23c4d, zero = 0;
+    uint16_t version[2] = {2, 4};
+    Put(&magic, sizeof(magic));
+    Put(version, sizeof(version));
+    Put(&zero, sizeof(zero));
+    Put(&zero, sizeof(zero));
+    Put(&snapLen, sizeof(snapLen));
+    Put(&linkType, sizeof(linkType));
+
+    Simulator::Schedule(start - Simulator::Now(), &SampledPcap::Connect,
+                        this);
+    if (stop > start)
+      Simulator::Schedule(stop - Simulator::Now(), &SampledPcap::Disconnect,
+                          this);
+  }
+
+  ~SampledPcap() {
+    Flush();
+    std::fclose(m_file);
+  }
+
+  // Packets in the window, and those written.
+  uint64_t GetSeen() const { return m_seen; }
+  uint64_t GetCaptured() const { return m_captured; }
+
+  void Flush() {
+    if (m_used > 0)
+      std::fwrite(m_buffer.data(), 1, m_used, m_file);
+    m_used = 0;
+  }
+
+private:
+  void Connect() {
+    m_device->TraceConnectWithoutContext(
+        "Sniffer", MakeCallback(&SampledPcap::Capture, this));
+  }
+
+  void Disconnect() {
+    m_device->TraceDisconnectWithoutContext(
+        "Sniffer", MakeCallback(&SampledPcap::Capture, this));
+  }
+
+  void Capture(Ptr<const Packet> packet) {
+    m_seen++;
+    m_credit += m_sampling;
+    if (m_credit < 1)
+      return;
+    m_credit -= 1;
+    m_captured++;
+
+    uint64_t ns = Simulator::Now().GetNanoSeconds();
+    uint32_t size = packet->GetSize();
+    uint32_t kept = packet->CopyData(m_record.data(), m_snapLen);
+    // seconds, nanoseconds, bytes kept, bytes on the wire
+    uint32_t header[4] = {(uint32_t)(ns / 1000000000),
+                          (uint32_t)(ns % 1000000000), kept, size};
+    Put(header, sizeof(header));
+    Put(m_record.data(), kept);
+  }
+
+  void Put(const void *bytes, std::size_t size) {
+    if (m_used + size > m_buffer.size())
+      Flush();
+    std::memcpy(m_buffer.data() + m_used, bytes, size);
+    m_used += size;
+  }
+
+  Ptr<NetDevice> m_device;
+  double m_sampling;
+  uint32_t m_snapLen;
+  double m_credit; // starts at 1 so the first packet is kept
+
+  std::FILE *m_file;
+  std::vector<uint8_t> m_buffer;
+  std::size_t m_used;
+  std::vector<uint8_t> m_record;
+
+  uint64_t m_seen;
+  uint64_t m_captured;
+};
+
+} // namespace ns3
+
+#endif /* SAMPLED_PCAP_H */
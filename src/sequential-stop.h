@@ -0,0 +1,118 @@
+#ifndef SEQUENTIAL_STOP_H
+#define SEQUENTIAL_STOP_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+#include "ns3/core-module.h"
+
+#include "batch-means.h"
+#include "queue-monitor.h"
+
+namespace ns3 {
+
+// Ends the run once a queue disc's steady-state mean occupancy and mean
+// sojourn time are known to a given precision, instead of after a fixed
+// time.
+//
+// Every interval from Start() on, the queue's mean occupancy and mean
+// sojourn time over that interval, the latter weighted by the packets that
+// left, go into a BatchMeans each (see batch-means.h), which drops the
+// warm-up and gives 95% intervals. Once both are past their warm-up and
+// both half-widths are within precision of their means, Simulator::Stop()
+// ends the run. Means below 0.01 packets and 1 us count as those, so a
+// queue that stays empty stops the run rather than chasing a relative
+// precision of 0.
+//
+// The queue has to be watched by the QueueMonitor with
+// WatchSojournTime(). Checks get further apart as the run goes on, one per
+// tenth more intervals, so they cost little over a long run.
+class SequentialStop {
+public:
+  SequentialStop(const QueueMonitor &monitor, std::string label,
+                 double precision)
+      : m_monitor(monitor), m_label(label), m_precision(precision),
+        m_converged(false), m_lastArea(0), m_lastCount(0), m_lastSum(0),
+        m_nextCheck(0) {}
+
+  void Start(Time start, Time interval) {
+    NS_ABORT_MSG_IF(!interval.IsStrictlyPositive(),
+                    "SequentialStop: interval must be positive");
+    m_start = start;
+    m_interval = interval;
+    Simulator::Schedule(start - Simulator::Now(), &SequentialStop::Begin,
+                        this);
+  }
+
+  bool HasConverged() const { return m_converged; }
+
+  // The occupancy in packets and the sojourn time in seconds, with the
+  // warm-up dropped.
+  const BatchMeans &GetPackets() const { return m_packets; }
+  const BatchMeans &GetSojourn() const { return m_sojourn; }
+
+  // The longer of the two warm-ups.
+  Time GetWarmup() const {
+    uint64_t intervals = std::max(m_packets.GetWarmup(), m_sojourn.GetWarmup());
+    return m_interval * (int64_t)intervals;
+  }
+
+private:
+  void Begin() {
+    m_lastArea = m_monitor.GetPacketSeconds(m_label);
+    m_lastCount = m_monitor.GetSojournCount(m_label);
+    m_lastSum = m_monitor.GetSojournSum(m_label);
+    Simulator::Schedule(m_interval, &SequentialStop::Observe, this, 1);
+  }
+
+  void Observe(uint64_t k) {
+    double area = m_monitor.GetPacketSeconds(m_label);
+    uint64_t count = m_monitor.GetSojournCount(m_label);
+    double sum = m_monitor.GetSojournSum(m_label);
+    m_packets.Add((area - m_lastArea) / m_interval.GetSeconds());
+    uint64_t left = count - m_lastCount;
+    m_sojourn.Add(left ? (sum - m_lastSum) / left : 0, left);
+    m_lastArea = area;
+    m_lastCount = count;
+    m_lastSum = sum;
+
+    if (k >= m_nextCheck) {
+      m_nextCheck = k + std::max<uint64_t>(1, k / 10);
+      if (IsPrecise(m_packets, 0.01) && IsPrecise(m_sojourn, 1e-6)) {
+        m_converged = true;
+        Simulator::Stop();
+        return;
+      }
+    }
+    // Like QueueMonitor sampling, on the start + k * interval grid.
+    Time next = m_start + m_interval * (int64_t)(k + 1);
+    Simulator::Schedule(next - Simulator::Now(), &SequentialStop::Observe,
+                        this, k + 1);
+  }
+
+  bool IsPrecise(const BatchMeans &estimate, double floor) const {
+    if (!estimate.IsSteady())
+      return false;
+    double halfWidth = estimate.GetHalfWidth();
+    return halfWidth <=
+           m_precision * std::max(std::fabs(estimate.GetMean()), floor);
+  }
+
+  const QueueMonitor &m_monitor;
+  std::string m_label;
+  double m_precision;
+  Time m_start, m_interval;
+
+  bool m_converged;
+  BatchMeans m_packets, m_sojourn;
+  double m_lastArea;
+  uint64_t m_lastCount;
+  double m_lastSum;
+  uint64_t m_nextCheck;
+};
+
+} // namespace ns3
+
+#endif /* SEQUENTIAL_STOP_H */
@@ -0,0 +1,176 @@
+#ifndef SERVER_REFLECTOR_H
+#define SERVER_REFLECTOR_H
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "alloc-counter.h"
+#include "bulk-rng.h"
+
+namespace ns3 {
+
+// Reflects what a UdpServer receives: with probability ForwardProbability a
+// packet of the same size goes out on the forward socket, otherwise it goes
+// back to the sender on the bounce socket.
+//
+// The decisions come from a UniformRandomVariable, drawn BlockSize values
+// at a time (see bulk-rng.h), so a packet costs an array read rather than
+// creating and seeding a random variable. The variable's stream can be fixed
+// with AssignStreams() like any ns-3 model.
+//
+// AssignSourceStream() gives a sender a stream of its own, so the k-th
+// packet from that sender gets the same decision whatever else arrives in
+// between; two runs that differ in the links, and so in the order packets
+// from different senders reach S, still reflect the same packets the same
+// way (common random numbers). A loss on the way to S shifts that sender's
+// later decisions by one. Antithetic decides on 1 - U instead of U.
+//
+// The sockets take ownership of what they send and prepend headers to it,
+// so the outgoing packet is necessarily a new one. What the reflection path
+// still allocates per packet, the stack below Send() included, is counted
+// through alloc-counter.h and reported by GetAllocationsPerPacket(); the
+// program includes alloc-counter-impl.h in its main file.
+class ServerReflector : public Object {
+public:
+  static TypeId GetTypeId() {
+    static TypeId tid =
+        TypeId("ns3::ServerReflector")
+            .SetParent<Object>()
+            .AddConstructor<ServerReflector>()
+            .AddAttribute("ForwardProbability",
+                          "Probability that a packet is forwarded rather "
+                          "than bounced back to its sender",
+                          DoubleValue(0.7),
+                          MakeDoubleAccessor(
+                              &ServerReflector::m_forwardProbability),
+                          MakeDoubleChecker<double>(0, 1))
+            .AddAttribute("Antithetic", "Decide on 1 - U",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&ServerReflector::m_antithetic),
+                          MakeBooleanChecker())
+            .AddAttribute("BlockSize",
+                          "Number of decisions drawn from the stream at once",
+                          UintegerValue(256),
+                          MakeUintegerAccessor(&ServerReflector::m_blockSize),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+  }
+
+  ServerReflector()
+      : m_forwardProbability(0.7), m_antithetic(false), m_blockSize(256),
+        m_forwarded(0), m_bounced(0), m_allocations(0) {
+    m_default.uniform = CreateObject<UniformRandomVariable>();
+  }
+
+  void Install(Ptr<UdpServer> server, Ptr<Socket> forward,
+               Ptr<Socket> bounce) {
+    m_forward = forward;
+    m_bounce = bounce;
+    server->TraceConnectWithoutContext(
+        "RxWithAddresses", MakeCallback(&ServerReflector::Receive, this));
+  }
+
+  // The stream for senders without one of their own.
+  int64_t AssignStreams(int64_t stream) {
+    m_default.SetStream(stream);
+    return 1;
+  }
+
+  void AssignSourceStream(Ipv4Address source, int64_t stream) {
+    Decisions &decisions = m_sources[source];
+    if (!decisions.uniform)
+      decisions.uniform = CreateObject<UniformRandomVariable>();
+    decisions.SetStream(stream);
+  }
+
+  uint64_t GetForwarded() const { return m_forwarded; }
+  uint64_t GetBounced() const { return m_bounced; }
+
+  double GetAllocationsPerPacket() const {
+    uint64_t packets = m_forwarded + m_bounced;
+    return packets ? (double)m_allocations / packets : 0;
+  }
+
+protected:
+  virtual void DoDispose() {
+    m_forward = 0;
+    m_bounce = 0;
+    m_default.uniform = 0;
+    m_sources.clear();
+    Object::DoDispose();
+  }
+
+private:
+  struct Decisions {
+    Decisions() : next(0) {}
+
+    void SetStream(int64_t stream) {
+      uniform->SetStream(stream);
+      // Whatever is left of the block came from the old stream.
+      block.clear();
+      next = 0;
+    }
+
+    Ptr<UniformRandomVariable> uniform;
+    std::vector<double> block;
+    std::size_t next;
+  };
+
+  double Decide(const Address &from) {
+    Decisions *decisions = &m_default;
+    if (!m_sources.empty() && InetSocketAddress::IsMatchingType(from)) {
+      std::map<Ipv4Address, Decisions>::iterator it =
+          m_sources.find(InetSocketAddress::ConvertFrom(from).GetIpv4());
+      if (it != m_sources.end())
+        decisions = &it->second;
+    }
+    if (decisions->next == decisions->block.size()) {
+      decisions->block.resize(m_blockSize);
+      bulk_uniform(Rng_stream_access::get(decisions->uniform), 0, 1,
+                   m_antithetic, decisions->block.data(),
+                   decisions->block.size());
+      decisions->next = 0;
+    }
+    return decisions->block[decisions->next++];
+  }
+
+  void Receive(Ptr<const Packet> packet, const Address &from,
+               const Address &to) {
+    Alloc_snapshot before = alloc_snapshot();
+
+    if (Decide(from) <= m_forwardProbability) {
+      m_forward->Send(Create<Packet>(packet->GetSize()));
+      m_forwarded++;
+    } else {
+      m_bounce->SendTo(Create<Packet>(packet->GetSize()), 0, from);
+      m_bounced++;
+    }
+
+    m_allocations += alloc_snapshot().calls - before.calls;
+  }
+
+  double m_forwardProbability;
+  bool m_antithetic;
+  uint32_t m_blockSize;
+  Decisions m_default;
+  std::map<Ipv4Address, Decisions> m_sources;
+
+  Ptr<Socket> m_forward;
+  Ptr<Socket> m_bounce;
+
+  uint64_t m_forwarded;
+  uint64_t m_bounced;
+  uint64_t m_allocations;
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ServerReflector);
+
+} // namespace ns3
+
+#endif /* SERVER_REFLECTOR_H */